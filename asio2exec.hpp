@@ -22,45 +22,460 @@
 
 #pragma once
 
+// asio在编译期选择reactor：这些宏应当由构建系统为每个翻译单元定义，
+// 这里只在asio2exec.hpp先于任何asio头文件被包含时补上；asio的配置已经以epoll生效时报错
+#if defined(ASIO_TO_EXEC_USE_IO_URING)
+#if !defined(ASIO_TO_EXEC_USE_BOOST)
+#if defined(ASIO_DETAIL_CONFIG_HPP) && (!defined(ASIO_HAS_IO_URING) || !defined(ASIO_DISABLE_EPOLL))
+#error "ASIO_TO_EXEC_USE_IO_URING: asio was included before asio2exec.hpp without ASIO_HAS_IO_URING and ASIO_DISABLE_EPOLL; define them for every translation unit."
+#endif
+#if !defined(ASIO_HAS_IO_URING)
+#define ASIO_HAS_IO_URING 1
+#endif
+#if !defined(ASIO_DISABLE_EPOLL)
+#define ASIO_DISABLE_EPOLL 1
+#endif
+#else
+#if defined(BOOST_ASIO_DETAIL_CONFIG_HPP) && (!defined(BOOST_ASIO_HAS_IO_URING) || !defined(BOOST_ASIO_DISABLE_EPOLL))
+#error "ASIO_TO_EXEC_USE_IO_URING: Boost.Asio was included before asio2exec.hpp without BOOST_ASIO_HAS_IO_URING and BOOST_ASIO_DISABLE_EPOLL; define them for every translation unit."
+#endif
+#if !defined(BOOST_ASIO_HAS_IO_URING)
+#define BOOST_ASIO_HAS_IO_URING 1
+#endif
+#if !defined(BOOST_ASIO_DISABLE_EPOLL)
+#define BOOST_ASIO_DISABLE_EPOLL 1
+#endif
+#endif
+#endif
+
 #if !defined(ASIO_TO_EXEC_USE_BOOST)
 #include <asio/any_io_executor.hpp>
 #include <asio/async_result.hpp>
 #include <asio/error_code.hpp>
+#include <asio/system_error.hpp>
 #include <asio/io_context.hpp>
 #include <asio/cancellation_signal.hpp>
+#include <asio/cancellation_state.hpp>
+#include <asio/recycling_allocator.hpp>
 #include <asio/associated_executor.hpp>
 #include <asio/post.hpp>
+#include <asio/dispatch.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/read_at.hpp>
+#include <asio/write_at.hpp>
+#include <asio/compose.hpp>
+#include <asio/socket_base.hpp>
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#include <asio/version.hpp>
+#if ASIO_VERSION >= 102400
+#include <asio/deferred.hpp>
+#define ASIO_TO_EXEC_HAS_DEFERRED 1
+#endif
 #else
 #include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/async_result.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/cancellation_state.hpp>
+#include <boost/asio/recycling_allocator.hpp>
 #include <boost/asio/associated_executor.hpp>
 #include <boost/asio/post.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/read_at.hpp>
+#include <boost/asio/write_at.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/socket_base.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/version.hpp>
+#if BOOST_ASIO_VERSION >= 102400
+#include <boost/asio/deferred.hpp>
+#define ASIO_TO_EXEC_HAS_DEFERRED 1
+#endif
 #endif
 
 #include <stdexec/execution.hpp>
+#include <exec/sequence_senders.hpp>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
 #include <cstring>
+#include <map>
 #include <memory>
 #include <memory_resource>
+#include <mutex>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
+
+#if defined(ASIO_TO_EXEC_ENABLE_TRACING)
+#include <ostream>
+#include <string_view>
+#endif
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 namespace asio2exec {
 
 namespace __ex = stdexec;
 #if !defined(ASIO_TO_EXEC_USE_BOOST)
 namespace __io = asio;
+using __error_code = asio::error_code;
+using __system_error = asio::system_error;
 #else
 namespace __io = boost::asio;
+using __error_code = boost::system::error_code;
+using __system_error = boost::system::system_error;
+#endif
+
+struct latency_histogram_snapshot {
+    // buckets[i] 统计落在 [2^(i-1), 2^i) 纳秒区间的样本数
+    std::array<std::uint64_t, 64> buckets{};
+
+    std::uint64_t count() const noexcept {
+        std::uint64_t n = 0;
+        for(auto b: buckets)
+            n += b;
+        return n;
+    }
+
+    // 返回所在桶的上界，精度为2的幂
+    std::chrono::nanoseconds percentile(double p) const noexcept {
+        const std::uint64_t total = count();
+        if(total == 0)
+            return std::chrono::nanoseconds{0};
+        const auto rank = static_cast<std::uint64_t>(p * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < buckets.size(); ++i){
+            seen += buckets[i];
+            if(seen >= rank)
+                return std::chrono::nanoseconds{i == 0 ? 0 : (std::int64_t{1} << std::min<std::size_t>(i, 62))};
+        }
+        return std::chrono::nanoseconds::max();
+    }
+};
+
+struct context_metrics_snapshot {
+    std::uint64_t handlers_posted = 0;
+    std::uint64_t handlers_executed = 0;
+    std::uint64_t queue_depth = 0;
+    latency_histogram_snapshot schedule_latency{};
+    latency_histogram_snapshot io_latency{};
+    std::uint64_t stop_requests = 0;
+    std::uint64_t stopped = 0;
+    std::uint64_t sbo_hits = 0;
+    std::uint64_t upstream_allocations = 0;
+};
+
+class context_metrics {
+public:
+    context_metrics() = default;
+    context_metrics(const context_metrics&) = delete;
+    context_metrics& operator=(const context_metrics&) = delete;
+
+    context_metrics_snapshot snapshot() const noexcept {
+        context_metrics_snapshot s;
+        s.handlers_executed = _executed.load(std::memory_order_relaxed);
+        s.handlers_posted = _posted.load(std::memory_order_relaxed);
+        s.queue_depth = s.handlers_posted > s.handlers_executed ? s.handlers_posted - s.handlers_executed : 0;
+        __load(_schedule_latency, s.schedule_latency);
+        __load(_io_latency, s.io_latency);
+        s.stop_requests = _stop_requests.load(std::memory_order_relaxed);
+        s.stopped = _stopped.load(std::memory_order_relaxed);
+        s.sbo_hits = _sbo_hits.load(std::memory_order_relaxed);
+        s.upstream_allocations = _upstream_allocations.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // 在post之前计数，使handlers_posted不会落后于handlers_executed；post抛出时撤回
+    void __on_post()noexcept { _posted.fetch_add(1, std::memory_order_relaxed); }
+    void __on_post_failed()noexcept { _posted.fetch_sub(1, std::memory_order_relaxed); }
+    void __on_execute(std::chrono::nanoseconds latency)noexcept {
+        _executed.fetch_add(1, std::memory_order_relaxed);
+        __record(_schedule_latency, latency);
+    }
+    void __on_io_complete(std::chrono::nanoseconds latency)noexcept { __record(_io_latency, latency); }
+    void __on_stop_request()noexcept { _stop_requests.fetch_add(1, std::memory_order_relaxed); }
+    void __on_stopped()noexcept { _stopped.fetch_add(1, std::memory_order_relaxed); }
+    void __on_allocate(bool sbo_hit)noexcept {
+        (sbo_hit ? _sbo_hits : _upstream_allocations).fetch_add(1, std::memory_order_relaxed);
+    }
+private:
+    using __histogram_t = std::array<std::atomic<std::uint64_t>, 64>;
+
+    static void __record(__histogram_t& h, std::chrono::nanoseconds d)noexcept {
+        const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(d.count(), 0));
+        h[std::min<std::size_t>(std::bit_width(ns), h.size() - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void __load(const __histogram_t& h, latency_histogram_snapshot& out)noexcept {
+        for(std::size_t i = 0; i < h.size(); ++i)
+            out.buckets[i] = h[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t> _posted{0};
+    std::atomic<std::uint64_t> _executed{0};
+    __histogram_t _schedule_latency{};
+    __histogram_t _io_latency{};
+    std::atomic<std::uint64_t> _stop_requests{0};
+    std::atomic<std::uint64_t> _stopped{0};
+    std::atomic<std::uint64_t> _sbo_hits{0};
+    std::atomic<std::uint64_t> _upstream_allocations{0};
+};
+
+namespace __detail{
+
+// 定义ASIO_TO_EXEC_ENABLE_METRICS后启用统计，否则以下类型均为空操作
+#if defined(ASIO_TO_EXEC_ENABLE_METRICS)
+inline thread_local context_metrics* __this_thread_metrics = nullptr;
+
+struct __metrics_handle {
+    context_metrics* _m = nullptr;
+
+    static __metrics_handle __current()noexcept { return {__this_thread_metrics}; }
+    context_metrics* __get()const noexcept { return _m ? _m : __this_thread_metrics; }
+    // 统计对象不参与调度器的相等性比较
+    bool operator==(const __metrics_handle&)const noexcept { return true; }
+};
+
+struct __stamp {
+    std::chrono::steady_clock::time_point _t{};
+
+    void __mark()noexcept { _t = std::chrono::steady_clock::now(); }
+    std::chrono::nanoseconds __elapsed()const noexcept { return std::chrono::steady_clock::now() - _t; }
+};
+
+template<class F>
+void __with_metrics(const __metrics_handle& h, F&& f)noexcept {
+    if(context_metrics* m = h.__get())
+        std::forward<F>(f)(*m);
+}
+#else
+struct __metrics_handle {
+    static __metrics_handle __current()noexcept { return {}; }
+    bool operator==(const __metrics_handle&)const noexcept { return true; }
+};
+
+struct __stamp {
+    void __mark()noexcept {}
+    std::chrono::nanoseconds __elapsed()const noexcept { return std::chrono::nanoseconds{0}; }
+};
+
+template<class F>
+void __with_metrics(const __metrics_handle&, F&&)noexcept {}
+#endif
+
+} // namespace __detail
+
+namespace __detail{
+
+enum class __trace_phase: unsigned char {
+    start, initiate, complete, stop_requested, stopped
+};
+
+// 定义ASIO_TO_EXEC_ENABLE_TRACING后记录每个操作的生命周期事件，否则__trace为空操作
+#if defined(ASIO_TO_EXEC_ENABLE_TRACING)
+// 单写者环形缓冲区，每个线程一个；读者只在导出时复制
+class __trace_ring {
+public:
+    static constexpr std::size_t capacity = std::size_t{1} << 14;
+
+    struct __event_t {
+        std::atomic<std::int64_t> ts{0};
+        std::atomic<const void*> id{nullptr};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<__trace_phase> phase{__trace_phase::start};
+    };
+
+    struct __record_t {
+        std::int64_t ts;
+        const void* id;
+        const char* name;
+        __trace_phase phase;
+    };
+
+    explicit __trace_ring(std::size_t tid)noexcept: _tid{tid} {}
+
+    void push(const void* id, const char* name, __trace_phase phase)noexcept {
+        const std::uint64_t h = _head.load(std::memory_order_relaxed);
+        __event_t& e = _events[h & (capacity - 1)];
+        e.ts.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        e.id.store(id, std::memory_order_relaxed);
+        e.name.store(name, std::memory_order_relaxed);
+        e.phase.store(phase, std::memory_order_relaxed);
+        _head.store(h + 1, std::memory_order_release);
+    }
+
+    template<class F>
+    void for_each(F&& f)const {
+        const std::uint64_t end = _head.load(std::memory_order_acquire);
+        const std::uint64_t begin = end > capacity ? end - capacity : 0;
+        std::vector<__record_t> records;
+        records.reserve(end - begin);
+        for(std::uint64_t i = begin; i < end; ++i){
+            const __event_t& e = _events[i & (capacity - 1)];
+            records.push_back({
+                e.ts.load(std::memory_order_relaxed),
+                e.id.load(std::memory_order_relaxed),
+                e.name.load(std::memory_order_relaxed),
+                e.phase.load(std::memory_order_relaxed)
+            });
+        }
+        // 复制期间被写者覆盖的槽位丢弃
+        const std::uint64_t after = _head.load(std::memory_order_acquire);
+        const std::uint64_t valid_from = after > capacity ? after - capacity : 0;
+        for(std::uint64_t i = std::max(begin, valid_from); i < end; ++i)
+            f(records[i - begin]);
+    }
+
+    std::size_t tid()const noexcept { return _tid; }
+private:
+    std::size_t _tid;
+    std::atomic<std::uint64_t> _head{0};
+    std::array<__event_t, capacity> _events{};
+};
+
+struct __trace_registry {
+    std::mutex mtx;
+    std::vector<std::shared_ptr<__trace_ring>> rings;
+
+    static __trace_registry& instance()noexcept {
+        static __trace_registry r;
+        return r;
+    }
+
+    // 线程退出后缓冲区仍由注册表持有，可继续导出
+    static __trace_ring* this_thread() {
+        thread_local std::shared_ptr<__trace_ring> ring = []{
+            __trace_registry& r = instance();
+            std::lock_guard lk{r.mtx};
+            auto p = std::make_shared<__trace_ring>(r.rings.size() + 1);
+            r.rings.push_back(p);
+            return p;
+        }();
+        return ring.get();
+    }
+};
+
+inline void __trace(const void* id, const char* name, __trace_phase phase)noexcept {
+    try{
+        __trace_registry::this_thread()->push(id, name, phase);
+    }catch(...){}
+}
+
+// 从函数签名中取出T的名字
+template<class T>
+constexpr std::string_view __pretty_name()noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    constexpr std::string_view sig = __FUNCSIG__;
+    constexpr std::string_view open = "__pretty_name<";
+    const auto b = sig.find(open) + open.size();
+    const auto e = sig.rfind(">(void)");
+#else
+    // gcc: "... [with T = X; ...]"，clang: "... [T = X]"
+    constexpr std::string_view sig = __PRETTY_FUNCTION__;
+    const auto b = sig.find("T = ") + 4;
+    auto e = sig.find(';', b);
+    if(e == std::string_view::npos)
+        e = sig.rfind(']');
+#endif
+    return sig.substr(b, e - b);
+}
+
+// 以T的名字作为跟踪事件名，存放在静态存储中
+template<class T>
+struct __type_name {
+    static constexpr auto __storage = []{
+        constexpr std::string_view name = __pretty_name<T>();
+        std::array<char, name.size() + 1> buf{};
+        std::ranges::copy(name, buf.begin());
+        return buf;
+    }();
+    static constexpr const char* value = __storage.data();
+};
+#else
+inline void __trace(const void*, const char*, __trace_phase)noexcept {}
+
+template<class T>
+struct __type_name {
+    static constexpr const char* value = "";
+};
+#endif
+
+} // namespace __detail
+
+#if defined(ASIO_TO_EXEC_ENABLE_TRACING)
+// 以Chrome trace / Perfetto的JSON格式导出所有线程已记录的事件
+inline void write_chrome_trace(std::ostream& os) {
+    using __detail::__trace_phase;
+    __detail::__trace_registry& r = __detail::__trace_registry::instance();
+    std::vector<std::shared_ptr<__detail::__trace_ring>> rings;
+    {
+        std::lock_guard lk{r.mtx};
+        rings = r.rings;
+    }
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    for(const auto& ring: rings){
+        ring->for_each([&](const __detail::__trace_ring::__record_t& e){
+            const char* ph = "n";
+            const char* detail = nullptr;
+            switch(e.phase){
+                case __trace_phase::start: ph = "b"; break;
+                case __trace_phase::initiate: detail = "initiate"; break;
+                case __trace_phase::complete: ph = "e"; break;
+                case __trace_phase::stop_requested: detail = "stop_requested"; break;
+                case __trace_phase::stopped: ph = "e"; detail = "stopped"; break;
+            }
+            if(!first)
+                os << ',';
+            first = false;
+            os << "{\"name\":\"";
+            // 类型名中的引号与反斜杠需要转义
+            for(const char* c = e.name && *e.name ? e.name : "op"; *c; ++c){
+                if(*c == '"' || *c == '\\')
+                    os << '\\';
+                os << *c;
+            }
+            os << "\",\"cat\":\"asio2exec\",\"ph\":\"" << ph
+               << "\",\"id\":\"" << e.id
+               << "\",\"pid\":1,\"tid\":" << ring->tid()
+               << ",\"ts\":" << e.ts / 1000 << '.'
+               << static_cast<char>('0' + e.ts / 100 % 10)
+               << static_cast<char>('0' + e.ts / 10 % 10)
+               << static_cast<char>('0' + e.ts % 10);
+            if(detail)
+                os << ",\"args\":{\"event\":\"" << detail << "\"}";
+            os << '}';
+        });
+    }
+    os << "]}";
+}
 #endif
 
 namespace __detail{
@@ -77,12 +492,20 @@ public:
     __sbo_buffer(__sbo_buffer&&)=delete;
     __sbo_buffer& operator=(__sbo_buffer&&)=delete;
 
+    // 只能在分配任何内存之前更换上游
+    void __rebind(std::pmr::memory_resource* upstream)noexcept {
+        assert(!_used && "Rebinding a __sbo_buffer in use.");
+        _upstream = upstream;
+    }
+
 private:
     void* do_allocate(size_t bytes, size_t alignment) override{
         if(_used || bytes > Size || alignment > Alignment){
             assert(_upstream && "Upstream memory_resource is empty.");
+            __with_metrics(__metrics_handle::__current(), [](context_metrics& m){ m.__on_allocate(false); });
             return _upstream->allocate(bytes, alignment);
         }
+        __with_metrics(__metrics_handle::__current(), [](context_metrics& m){ m.__on_allocate(true); });
         _used = true;
         return &_storage;
     }
@@ -105,6 +528,16 @@ private:
     alignas(Alignment) unsigned char _storage[Size];
 };
 
+// 接收者环境通过get_allocator提供std::pmr分配器时，以其内存资源作为溢出分配的上游，否则使用默认资源
+template<class Env>
+std::pmr::memory_resource* __env_resource(const Env& env)noexcept {
+    if constexpr(requires { { __ex::get_allocator(env).resource() } -> std::convertible_to<std::pmr::memory_resource*>; }){
+        if(std::pmr::memory_resource* r = __ex::get_allocator(env).resource())
+            return r;
+    }
+    return std::pmr::get_default_resource();
+}
+
 template <class Executor = __io::any_io_executor>
 struct basic_scheduler {
     using executor_type = Executor;
@@ -121,10 +554,15 @@ struct basic_scheduler {
         _executor{ctx.get_executor()}
     {}
 
+    basic_scheduler(executor_type ex, __metrics_handle metrics)noexcept:
+        _executor{std::move(ex)},
+        _metrics{metrics}
+    {}
+
     bool operator==(const basic_scheduler&)const noexcept = default;
 
     auto schedule() const noexcept {
-        return __schedule_sender_t{ _executor };
+        return __schedule_sender_t{ _executor, _metrics };
     }
 
     executor_type get_executor() const noexcept {
@@ -140,12 +578,14 @@ private:
         >;
 
         executor_type _executor;
+        __metrics_handle _metrics;
 
         struct __env_t {
             executor_type executor;
+            __metrics_handle metrics;
             template<class CPO>
             auto query(__ex::get_completion_scheduler_t<CPO>) const noexcept {
-                return basic_scheduler{ executor };
+                return basic_scheduler{ executor, metrics };
             }
         };
 
@@ -155,12 +595,15 @@ private:
 
             executor_type _executor;
             R _r;
-            __sbo_buffer<128> _buf{};
+            __sbo_buffer<128> _buf{ __env_resource(__ex::get_env(_r)) };
+            __metrics_handle _metrics;
+            __stamp _posted_at{};
 
             template<__ex::receiver _R>
-            __op(executor_type ex, _R&& r)noexcept:
+            __op(executor_type ex, __metrics_handle metrics, _R&& r)noexcept:
                 _executor{ std::move(ex) },
-                _r{ std::forward<_R>(r) }
+                _r{ std::forward<_R>(r) },
+                _metrics{ metrics }
             {}
 
             __op(const __op&) = delete;
@@ -178,22 +621,32 @@ private:
                 executor_type get_executor() const noexcept { return self->_executor; }
 
                 void operator()()noexcept{
+                    __with_metrics(self->_metrics, [this](context_metrics& m){
+                        m.__on_execute(self->_posted_at.__elapsed());
+                    });
+                    __trace(self, "schedule", __trace_phase::complete);
                     __ex::set_value(std::move(self->_r));
                 }
             };
 
             void start() & noexcept{
+                __trace(this, "schedule", __trace_phase::start);
                 if constexpr(!__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
                     const __ex::stoppable_token auto st = __ex::get_stop_token(__ex::get_env(_r));
                     if(st.stop_requested()){
+                        __with_metrics(_metrics, [](context_metrics& m){ m.__on_stopped(); });
+                        __trace(this, "schedule", __trace_phase::stopped);
                         __ex::set_stopped(std::move(_r));
                         return;
                     }
                 }
+                _posted_at.__mark();
+                __with_metrics(_metrics, [](context_metrics& m){ m.__on_post(); });
                 try{
                     __io::post(_executor, __sched_task_t{this});
                 }
                 catch (...) {
+                    __with_metrics(_metrics, [](context_metrics& m){ m.__on_post_failed(); });
                     __ex::set_error(std::move(_r), std::current_exception());
                 }
             }
@@ -201,132 +654,2002 @@ private:
 
         template<__ex::receiver R>
         auto connect(R&& r) && {
-            return __op<std::decay_t<R>>{ std::move(_executor), std::forward<R>(r) };
+            return __op<std::decay_t<R>>{ std::move(_executor), _metrics, std::forward<R>(r) };
         }
 
         __env_t get_env() const noexcept {
-            return __env_t{ _executor };
+            return __env_t{ _executor, _metrics };
         }
 
     };
 
     executor_type _executor;
+    [[no_unique_address]] __metrics_handle _metrics{};
 };
 
 } // namespace __detail
 
-class asio_context {
-public:
-    using scheduler_type = __detail::basic_scheduler<__io::io_context::executor_type>;
+enum class priority: unsigned char {
+    high, normal, low
+};
 
-    asio_context():
-        _self{std::in_place},
-        _ctx{*_self},
-        _guard{std::in_place, __io::make_work_guard(_ctx) }
-    {}
+struct priority_policy {
+    // true时总是先执行更高优先级的lane；否则按weights加权轮转
+    bool strict = false;
+    std::array<unsigned, 3> weights{8, 4, 1};
+    // 队首等待超过该时长的任务会被提前执行
+    std::chrono::nanoseconds starvation_limit = std::chrono::milliseconds(50);
+    // 每次post最多执行的任务数，之后让出给io完成
+    std::size_t batch = 64;
+};
 
-    asio_context(__io::io_context& ctx):
+struct lane_stats {
+    std::uint64_t executed = 0;
+    std::uint64_t promoted = 0;
+    std::chrono::nanoseconds total_wait{};
+    std::chrono::nanoseconds max_wait{};
+
+    std::chrono::nanoseconds mean_wait()const noexcept {
+        return executed ? total_wait / static_cast<std::int64_t>(executed) : std::chrono::nanoseconds{};
+    }
+};
+
+namespace __detail {
+
+struct __priority_node {
+    __priority_node* _next = nullptr;
+    void (*_execute)(__priority_node*) noexcept = nullptr;
+    // 所属的__priority_lanes析构时仍在队列中的节点经此以set_stopped完成
+    void (*_abandon)(__priority_node*) noexcept = nullptr;
+    std::chrono::steady_clock::time_point _enqueued{};
+};
+
+// 每个优先级一个FIFO，由一个post到io_context的处理器按策略取出执行
+class __priority_lanes {
+public:
+    static constexpr std::size_t __lane_count = 3;
+
+    explicit __priority_lanes(__io::io_context& ctx):
         _ctx{ctx}
     {}
 
-    asio_context(const asio_context&) = delete;
-    asio_context(asio_context&&) = delete;
-    asio_context& operator=(const asio_context&) = delete;
-    asio_context& operator=(asio_context&&) = delete;
-
-    ~asio_context() {
-        join();
-    }
+    __priority_lanes(const __priority_lanes&) = delete;
+    __priority_lanes& operator=(const __priority_lanes&) = delete;
 
-    void start() {
-        _th = std::thread([this] {
-            _ctx.run();
-        });
+    // 包装外部io_context时，已post的排空处理器可能在此之后才执行
+    ~__priority_lanes() {
+        {
+            std::lock_guard live{_liveness->mtx};
+            _liveness->lanes = nullptr;
+        }
+        std::array<__queue, __lane_count> lanes;
+        {
+            std::lock_guard lk{_mtx};
+            lanes = std::exchange(_lanes, {});
+        }
+        for(auto& q: lanes){
+            while(q.head){
+                auto* n = std::exchange(q.head, q.head->_next);
+                n->_abandon(n);
+            }
+        }
     }
 
-    void stop()noexcept {
-        _guard.reset();
+    void set_policy(const priority_policy& policy) {
+        std::lock_guard lk{_mtx};
+        _policy = policy;
+        _credits = policy.weights;
     }
 
-    void join(){
-        stop();
-        if(_th.joinable())
-            _th.join();
+    void push(__priority_node* n, priority p) {
+        const auto lane = static_cast<std::size_t>(p);
+        n->_next = nullptr;
+        n->_enqueued = std::chrono::steady_clock::now();
+        bool post;
+        {
+            std::lock_guard lk{_mtx};
+            auto& q = _lanes[lane];
+            if(q.tail)
+                q.tail->_next = n;
+            else
+                q.head = n;
+            q.tail = n;
+            post = !std::exchange(_scheduled, true);
+        }
+        if(!post)
+            return;
+        try{
+            __post();
+        }catch(...){
+            // 没有排空任务会处理n，撤回后由调用方以set_error完成；
+            // 期间入队的其它节点看到_scheduled为true而没有post，需要替它们再post一次
+            bool others;
+            {
+                std::lock_guard lk{_mtx};
+                __remove(_lanes[lane], n);
+                others = std::ranges::any_of(_lanes, [](const __queue& q){ return q.head != nullptr; });
+                if(!others)
+                    _scheduled = false;
+            }
+            if(others){
+                try{
+                    __post();
+                }catch(...){
+                    std::lock_guard lk{_mtx};
+                    _scheduled = false;
+                }
+            }
+            throw;
+        }
     }
 
-    scheduler_type get_scheduler()noexcept {
-        return scheduler_type{_ctx};
+    lane_stats stats(priority p)const noexcept {
+        const auto& c = _counters[static_cast<std::size_t>(p)];
+        lane_stats st;
+        st.executed = c.executed.load(std::memory_order_relaxed);
+        st.promoted = c.promoted.load(std::memory_order_relaxed);
+        st.total_wait = std::chrono::nanoseconds{c.total_wait.load(std::memory_order_relaxed)};
+        st.max_wait = std::chrono::nanoseconds{c.max_wait.load(std::memory_order_relaxed)};
+        return st;
     }
 
-    __io::io_context& context()noexcept { return _ctx; }
-    const __io::io_context& context()const noexcept { return _ctx; }
 private:
-    std::optional<__io::io_context> _self{};
-    __io::io_context &_ctx;
-    std::optional<__io::executor_work_guard<__io::io_context::executor_type>> _guard{};
-    std::thread _th{};
-};
-
-template <bool TypeErased = false>
-struct basic_use_sender_t
-{
-    constexpr basic_use_sender_t() {}
+    struct __queue {
+        __priority_node* head = nullptr;
+        __priority_node* tail = nullptr;
+    };
 
-    template<class InnerExecutor>
-    struct executor_with_default : InnerExecutor
-    {
-        using default_completion_token_type = basic_use_sender_t;
+    struct __counters {
+        std::atomic<std::uint64_t> executed{0};
+        std::atomic<std::uint64_t> promoted{0};
+        std::atomic<std::int64_t> total_wait{0};
+        std::atomic<std::int64_t> max_wait{0};
+    };
 
-        executor_with_default(const InnerExecutor& ex)noexcept : InnerExecutor(ex) {}
+    struct __liveness_t {
+        explicit __liveness_t(__priority_lanes* l)noexcept:
+            lanes{l}
+        {}
 
-        template<class _InnerExecutor>
-            requires (!std::is_same_v<_InnerExecutor, executor_with_default> && std::is_convertible_v<_InnerExecutor, InnerExecutor>)
-        executor_with_default(const _InnerExecutor& ex)noexcept : InnerExecutor(ex) {}
+        std::mutex mtx{};
+        __priority_lanes* lanes;
     };
 
-    template<class T>
-    using as_default_on_t = typename T::template rebind_executor<
-        executor_with_default<typename T::executor_type>
-    >::other;
+    void __post() {
+        __io::post(_ctx, [live = _liveness]{ __drain(live); });
+    }
 
-    template<class T>
-    static typename std::decay_t<T>::template rebind_executor<
-        executor_with_default<typename std::decay_t<T>::executor_type>
-    >::other
-        as_default_on(T&& obj)
-    {
-        return typename std::decay_t<T>::template rebind_executor<
-            executor_with_default<typename std::decay_t<T>::executor_type>
-        >::other(std::forward<T>(obj));
+    // 持有_mtx时调用
+    static void __remove(__queue& q, __priority_node* n)noexcept {
+        __priority_node* prev = nullptr;
+        for(__priority_node* it = q.head; it; prev = it, it = it->_next){
+            if(it != n)
+                continue;
+            if(prev)
+                prev->_next = n->_next;
+            else
+                q.head = n->_next;
+            if(q.tail == n)
+                q.tail = prev;
+            n->_next = nullptr;
+            return;
+        }
     }
-};
 
-using use_sender_t = basic_use_sender_t<false>;
-using use_any_sender_t = basic_use_sender_t<true>;
+    // 持有_mtx时调用，返回选中的lane，全部为空时返回__lane_count
+    std::size_t __select(std::chrono::steady_clock::time_point now, bool allow_promote, bool& promoted)noexcept {
+        promoted = false;
+        // 饥饿保护：低优先级队首等待过久时先执行，每批最多一次，避免积压时反过来饿死高优先级
+        for(std::size_t i = __lane_count; allow_promote && i-- > 1;){
+            const auto* h = _lanes[i].head;
+            if(h && now - h->_enqueued > _policy.starvation_limit){
+                promoted = true;
+                return i;
+            }
+        }
+        if(_policy.strict){
+            for(std::size_t i = 0; i < __lane_count; ++i)
+                if(_lanes[i].head)
+                    return i;
+            return __lane_count;
+        }
+        for(int round = 0; round < 2; ++round){
+            for(std::size_t i = 0; i < __lane_count; ++i){
+                if(_lanes[i].head && _credits[i] > 0){
+                    --_credits[i];
+                    return i;
+                }
+            }
+            // 本轮额度用完，重新分配
+            _credits = _policy.weights;
+            for(auto& c: _credits)
+                c = std::max(c, 1u);
+        }
+        return __lane_count;
+    }
 
-inline constexpr use_sender_t use_sender{};
-inline constexpr use_any_sender_t use_any_sender{};
+    // 每次出队都在live->mtx下确认*this仍然存在，执行节点时不持有该锁
+    static void __drain(const std::shared_ptr<__liveness_t>& live)noexcept {
+        for(;;){
+            std::size_t budget;
+            {
+                std::lock_guard lk{live->mtx};
+                if(!live->lanes)
+                    return;
+                std::lock_guard lk2{live->lanes->_mtx};
+                budget = std::max<std::size_t>(live->lanes->_policy.batch, 1);
+            }
+            bool allow_promote = true;
+            for(; budget > 0; --budget){
+                __priority_node* n;
+                {
+                    std::lock_guard lk{live->mtx};
+                    auto* self = live->lanes;
+                    if(!self)
+                        return;
+                    const auto now = std::chrono::steady_clock::now();
+                    std::size_t lane;
+                    bool promoted;
+                    {
+                        std::lock_guard lk2{self->_mtx};
+                        lane = self->__select(now, allow_promote, promoted);
+                        allow_promote = allow_promote && !promoted;
+                        if(lane == __lane_count){
+                            self->_scheduled = false;
+                            return;
+                        }
+                        auto& q = self->_lanes[lane];
+                        n = q.head;
+                        q.head = n->_next;
+                        if(!q.head)
+                            q.tail = nullptr;
+                    }
+                    self->__record(lane, now - n->_enqueued, promoted);
+                }
+                n->_execute(n);
+            }
+            // 还有任务：让出给其他处理器后继续；post失败时_scheduled仍为true，
+            // 其它push不会再post，因此在当前线程接着排空
+            try{
+                std::lock_guard lk{live->mtx};
+                if(!live->lanes)
+                    return;
+                live->lanes->__post();
+                return;
+            }catch(...){}
+        }
+    }
 
-namespace __detail {
+    void __record(std::size_t lane, std::chrono::steady_clock::duration wait, bool promoted)noexcept {
+        auto& c = _counters[lane];
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+        c.executed.fetch_add(1, std::memory_order_relaxed);
+        c.total_wait.fetch_add(ns, std::memory_order_relaxed);
+        if(promoted)
+            c.promoted.fetch_add(1, std::memory_order_relaxed);
+        auto prev = c.max_wait.load(std::memory_order_relaxed);
+        while(ns > prev && !c.max_wait.compare_exchange_weak(prev, ns, std::memory_order_relaxed))
+            ;
+    }
 
-template<class ...Args>
-struct __op_base{
-    __op_base() = default;
-    __op_base(const __op_base&) = delete;
-    __op_base(__op_base&&) = delete;
-    __op_base& operator=(const __op_base&) = delete;
-    __op_base& operator=(__op_base&&) = delete;
-    virtual void complete(Args ...args)noexcept{};
+    __io::io_context& _ctx;
+    std::mutex _mtx{};
+    priority_policy _policy{};
+    std::array<unsigned, __lane_count> _credits{_policy.weights};
+    std::array<__queue, __lane_count> _lanes{};
+    bool _scheduled = false;
+    std::array<__counters, __lane_count> _counters{};
+    const std::shared_ptr<__liveness_t> _liveness{std::make_shared<__liveness_t>(this)};
 };
 
-template<class ...Args>
-struct use_sender_handler_base {
-    using allocator_type = std::pmr::polymorphic_allocator<>;
+} // namespace __detail
 
-    __op_base<Args...>* op;
-    allocator_type allocator;
+// asio_context::get_scheduler(priority)返回的调度器
+class priority_scheduler {
+public:
+    using scheduler_concept = __ex::scheduler_tag;
+    using executor_type = __io::io_context::executor_type;
 
-    allocator_type get_allocator() const noexcept { return allocator; }
+    priority_scheduler(__detail::__priority_lanes* lanes, __io::io_context* ctx, priority p)noexcept:
+        _lanes{lanes}, _ctx{ctx}, _priority{p}
+    {}
+
+    bool operator==(const priority_scheduler&)const noexcept = default;
+
+    auto schedule()const noexcept {
+        return __schedule_sender_t{ _lanes, _ctx, _priority };
+    }
+
+    executor_type get_executor()const noexcept {
+        return _ctx->get_executor();
+    }
+
+    priority get_priority()const noexcept {
+        return _priority;
+    }
+
+private:
+    struct __schedule_sender_t {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = __ex::completion_signatures<
+            __ex::set_value_t(),
+            __ex::set_error_t(std::exception_ptr),
+            __ex::set_stopped_t()
+        >;
+
+        __detail::__priority_lanes* _lanes;
+        __io::io_context* _ctx;
+        priority _priority;
+
+        struct __env_t {
+            __detail::__priority_lanes* lanes;
+            __io::io_context* ctx;
+            priority p;
+            template<class CPO>
+            priority_scheduler query(__ex::get_completion_scheduler_t<CPO>)const noexcept {
+                return priority_scheduler{ lanes, ctx, p };
+            }
+        };
+
+        template<__ex::receiver R>
+        struct __op: __detail::__priority_node {
+            using operation_state_concept = __ex::operation_state_tag;
+
+            __detail::__priority_lanes* _lanes;
+            priority _priority;
+            R _r;
+
+            template<__ex::receiver _R>
+            __op(__detail::__priority_lanes* lanes, priority p, _R&& r)noexcept:
+                _lanes{lanes},
+                _priority{p},
+                _r{std::forward<_R>(r)}
+            {
+                this->_execute = [](__detail::__priority_node* n)noexcept {
+                    auto* self = static_cast<__op*>(n);
+                    __detail::__trace(self, "priority", __detail::__trace_phase::complete);
+                    __ex::set_value(std::move(self->_r));
+                };
+                this->_abandon = [](__detail::__priority_node* n)noexcept {
+                    auto* self = static_cast<__op*>(n);
+                    __detail::__trace(self, "priority", __detail::__trace_phase::stopped);
+                    __ex::set_stopped(std::move(self->_r));
+                };
+            }
+
+            __op(const __op&) = delete;
+            __op(__op&&) = delete;
+            __op& operator=(const __op&) = delete;
+            __op& operator=(__op&&) = delete;
+
+            void start() & noexcept {
+                __detail::__trace(this, "priority", __detail::__trace_phase::start);
+                if constexpr(!__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
+                    if(__ex::get_stop_token(__ex::get_env(_r)).stop_requested()){
+                        __detail::__trace(this, "priority", __detail::__trace_phase::stopped);
+                        __ex::set_stopped(std::move(_r));
+                        return;
+                    }
+                }
+                try{
+                    _lanes->push(this, _priority);
+                }catch(...){
+                    __ex::set_error(std::move(_r), std::current_exception());
+                }
+            }
+        };
+
+        template<__ex::receiver R>
+        auto connect(R&& r) && {
+            return __op<std::decay_t<R>>{ _lanes, _priority, std::forward<R>(r) };
+        }
+
+        __env_t get_env()const noexcept {
+            return __env_t{ _lanes, _ctx, _priority };
+        }
+    };
+
+    __detail::__priority_lanes* _lanes;
+    __io::io_context* _ctx;
+    priority _priority;
+};
+
+class asio_context {
+public:
+    using scheduler_type = __detail::basic_scheduler<__io::io_context::executor_type>;
+
+    // socket与文件操作是否都由io_uring完成
+    static constexpr bool uses_io_uring()noexcept {
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT) || defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    asio_context():
+        _self{std::in_place},
+        _ctx{*_self},
+        _guard{std::in_place, __io::make_work_guard(_ctx) }
+    {}
+
+    // 不拥有ctx；析构时仍在优先级队列中的任务以set_stopped完成
+    asio_context(__io::io_context& ctx):
+        _ctx{ctx}
+    {}
+
+    asio_context(const asio_context&) = delete;
+    asio_context(asio_context&&) = delete;
+    asio_context& operator=(const asio_context&) = delete;
+    asio_context& operator=(asio_context&&) = delete;
+
+    ~asio_context() {
+        join();
+    }
+
+    void start() {
+        _th = std::thread([this] {
+#if defined(ASIO_TO_EXEC_ENABLE_METRICS)
+            __detail::__this_thread_metrics = &_metrics;
+#endif
+            _ctx.run();
+        });
+    }
+
+    void stop()noexcept {
+        _guard.reset();
+    }
+
+    void join(){
+        stop();
+        if(_th.joinable())
+            _th.join();
+    }
+
+    scheduler_type get_scheduler()noexcept {
+#if defined(ASIO_TO_EXEC_ENABLE_METRICS)
+        return scheduler_type{_ctx.get_executor(), __detail::__metrics_handle{&_metrics}};
+#else
+        return scheduler_type{_ctx};
+#endif
+    }
+
+    // 按优先级排队，由io线程按set_priority_policy设定的策略取出执行
+    priority_scheduler get_scheduler(priority p)noexcept {
+        return priority_scheduler{&_lanes, &_ctx, p};
+    }
+
+    void set_priority_policy(const priority_policy& policy) {
+        _lanes.set_policy(policy);
+    }
+
+    lane_stats priority_stats(priority p)const noexcept {
+        return _lanes.stats(p);
+    }
+
+    __io::io_context& context()noexcept { return _ctx; }
+    const __io::io_context& context()const noexcept { return _ctx; }
+
+#if defined(ASIO_TO_EXEC_ENABLE_METRICS)
+    context_metrics& metrics()noexcept { return _metrics; }
+    const context_metrics& metrics()const noexcept { return _metrics; }
+#endif
+private:
+    std::optional<__io::io_context> _self{};
+    __io::io_context &_ctx;
+    std::optional<__io::executor_work_guard<__io::io_context::executor_type>> _guard{};
+    std::thread _th{};
+    __detail::__priority_lanes _lanes{_ctx};
+#if defined(ASIO_TO_EXEC_ENABLE_METRICS)
+    context_metrics _metrics{};
+#endif
+};
+
+// 周期性地测量post到执行之间的延迟
+class lag_probe {
+public:
+    explicit lag_probe(__io::io_context& ctx, std::chrono::nanoseconds interval = std::chrono::milliseconds(10)):
+        _state{std::make_shared<__state_t>(ctx, interval)}
+    {}
+
+    explicit lag_probe(asio_context& ctx, std::chrono::nanoseconds interval = std::chrono::milliseconds(10)):
+        lag_probe(ctx.context(), interval)
+    {}
+
+    lag_probe(const lag_probe&) = delete;
+    lag_probe& operator=(const lag_probe&) = delete;
+
+    ~lag_probe() {
+        stop();
+    }
+
+    void start() {
+        if(_state->running.exchange(true, std::memory_order_acq_rel))
+            return;
+        const auto gen = _state->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+        try{
+            __io::post(_state->ctx, [st = _state, gen]{
+                __tick(st, gen);
+            });
+        }catch(...){
+            _state->running.store(false, std::memory_order_release);
+            throw;
+        }
+    }
+
+    void stop()noexcept {
+        if(!_state->running.exchange(false, std::memory_order_acq_rel))
+            return;
+        // 只取消本代的等待：stop()之后紧接着start()时，新一代的等待可能先于这次取消被设定
+        const auto gen = _state->generation.load(std::memory_order_acquire);
+        try{
+            __io::post(_state->ctx, [st = _state, gen]{
+                if(st->generation.load(std::memory_order_acquire) == gen)
+                    st->timer.cancel();
+            });
+        }catch(...){}
+    }
+
+    // 指数加权平均后的延迟
+    std::chrono::nanoseconds lag()const noexcept {
+        return std::chrono::nanoseconds{_state->smoothed.load(std::memory_order_relaxed)};
+    }
+
+    // 最近一次采样的延迟
+    std::chrono::nanoseconds last()const noexcept {
+        return std::chrono::nanoseconds{_state->last.load(std::memory_order_relaxed)};
+    }
+private:
+    struct __state_t {
+        __io::io_context& ctx;
+        __io::steady_timer timer;
+        std::chrono::nanoseconds interval;
+        std::atomic<bool> running{false};
+        // 每次start()递增，旧一代的回调看到不同的值后退出
+        std::atomic<std::uint64_t> generation{0};
+        std::atomic<std::int64_t> last{0};
+        std::atomic<std::int64_t> smoothed{0};
+
+        __state_t(__io::io_context& c, std::chrono::nanoseconds i):
+            ctx{c}, timer{c}, interval{i}
+        {}
+    };
+
+    static bool __current(const std::shared_ptr<__state_t>& st, std::uint64_t gen)noexcept {
+        return st->running.load(std::memory_order_acquire) && st->generation.load(std::memory_order_acquire) == gen;
+    }
+
+    static void __tick(const std::shared_ptr<__state_t>& st, std::uint64_t gen) {
+        if(!__current(st, gen))
+            return;
+        st->timer.expires_after(st->interval);
+        st->timer.async_wait([st, gen](const __error_code& ec){
+            if(ec || !__current(st, gen))
+                return;
+            __io::post(st->ctx, [st, gen, posted_at = std::chrono::steady_clock::now()]{
+                const std::int64_t sample = (std::chrono::steady_clock::now() - posted_at).count();
+                const std::int64_t prev = st->smoothed.load(std::memory_order_relaxed);
+                st->last.store(sample, std::memory_order_relaxed);
+                st->smoothed.store(prev + (sample - prev) / 8, std::memory_order_relaxed);
+                __tick(st, gen);
+            });
+        });
+    }
+
+    std::shared_ptr<__state_t> _state;
+};
+
+struct admission_policy {
+    const lag_probe* probe;
+    std::chrono::nanoseconds max_lag;
+};
+
+namespace __detail {
+
+template<class Scheduler>
+struct __admit_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    Scheduler _sched;
+    admission_policy _policy;
+
+    template<__ex::receiver R>
+    struct __op {
+        using operation_state_concept = __ex::operation_state_tag;
+
+        struct __receiver_t {
+            using receiver_concept = __ex::receiver_t;
+
+            __op* self;
+
+            void set_value()&& noexcept {
+                __ex::set_value(std::move(self->_r));
+            }
+
+            template<class E>
+            void set_error(E&& e)&& noexcept {
+                __ex::set_error(std::move(self->_r), std::forward<E>(e));
+            }
+
+            void set_stopped()&& noexcept {
+                __ex::set_stopped(std::move(self->_r));
+            }
+
+            __ex::env_of_t<R> get_env()const noexcept {
+                return __ex::get_env(self->_r);
+            }
+        };
+
+        using __inner_op_t = __ex::connect_result_t<__ex::schedule_result_t<Scheduler&>, __receiver_t>;
+
+        R _r;
+        admission_policy _policy;
+        __inner_op_t _inner;
+
+        template<__ex::receiver _R>
+        __op(Scheduler& sched, admission_policy policy, _R&& r):
+            _r{std::forward<_R>(r)},
+            _policy{policy},
+            _inner{__ex::connect(__ex::schedule(sched), __receiver_t{this})}
+        {}
+
+        __op(const __op&) = delete;
+        __op(__op&&) = delete;
+        __op& operator=(const __op&) = delete;
+        __op& operator=(__op&&) = delete;
+
+        void start() & noexcept{
+            // 过载时直接拒绝，不进入调度队列
+            if(_policy.probe && _policy.probe->lag() > _policy.max_lag){
+                __ex::set_stopped(std::move(_r));
+                return;
+            }
+            __ex::start(_inner);
+        }
+    };
+
+    template<__ex::receiver R>
+    auto connect(R&& r) && {
+        return __op<std::decay_t<R>>{ _sched, _policy, std::forward<R>(r) };
+    }
+};
+
+} // namespace __detail
+
+// 事件循环延迟超过阈值时以set_stopped完成，否则调度到sched上
+template<__ex::scheduler Scheduler>
+auto admit(Scheduler sched, admission_policy policy) {
+    return __detail::__admit_sender<Scheduler>{ std::move(sched), policy };
+}
+
+// 限制并发数量的作用域，子任务在asio_context上运行，join()时请求停止并等待全部结束
+class bounded_scope {
+public:
+    bounded_scope(asio_context& ctx, std::size_t max_in_flight):
+        _ctx{ctx},
+        _max{std::max<std::size_t>(max_in_flight, 1)}
+    {}
+
+    bounded_scope(const bounded_scope&) = delete;
+    bounded_scope(bounded_scope&&) = delete;
+    bounded_scope& operator=(const bounded_scope&) = delete;
+    bounded_scope& operator=(bounded_scope&&) = delete;
+
+    ~bounded_scope() {
+        join();
+    }
+
+    // 返回的sender在子任务获准运行后完成；达到上限时等待空位
+    template<__ex::sender S>
+    auto spawn(S&& sndr);
+
+    void request_stop()noexcept {
+        _stop_source.request_stop();
+        __waiter_base* waiters;
+        {
+            std::lock_guard lk{_mtx};
+            waiters = std::exchange(_head, nullptr);
+            _tail = nullptr;
+            for(__waiter_base* w = waiters; w; w = w->_next)
+                w->_queued = false;
+        }
+        while(waiters){
+            __waiter_base* next = waiters->_next;
+            waiters->_cancel(waiters);
+            waiters = next;
+        }
+        _cv.notify_all();
+    }
+
+    // 不能在所绑定的asio_context线程内调用
+    void join() {
+        assert(!_ctx.context().get_executor().running_in_this_thread() && "join() would deadlock on its own context.");
+        request_stop();
+        std::unique_lock lk{_mtx};
+        _cv.wait(lk, [this]{ return _in_flight == 0; });
+    }
+
+    std::size_t in_flight()const noexcept {
+        std::lock_guard lk{_mtx};
+        return _in_flight;
+    }
+
+    __ex::inplace_stop_token get_stop_token()const noexcept {
+        return _stop_source.get_token();
+    }
+private:
+    struct __waiter_base {
+        __waiter_base* _next = nullptr;
+        __waiter_base* _prev = nullptr;
+        bool _queued = false;
+        void (*_admit)(__waiter_base*) noexcept = nullptr;
+        void (*_cancel)(__waiter_base*) noexcept = nullptr;
+    };
+
+    struct __env_t {
+        bounded_scope* scope;
+
+        __ex::inplace_stop_token query(__ex::get_stop_token_t)const noexcept {
+            return scope->_stop_source.get_token();
+        }
+
+        asio_context::scheduler_type query(__ex::get_scheduler_t)const noexcept {
+            return scope->_ctx.get_scheduler();
+        }
+    };
+
+    template<class S>
+    struct __child_op {
+        struct __receiver_t {
+            using receiver_concept = __ex::receiver_t;
+
+            __child_op* self;
+
+            template<class ...Ts>
+            void set_value(Ts&&...)&& noexcept {
+                self->__done();
+            }
+
+            template<class E>
+            void set_error(E&&)&& noexcept {
+                // 与exec::start_detached一致，子任务不应以错误完成
+                std::terminate();
+            }
+
+            void set_stopped()&& noexcept {
+                self->__done();
+            }
+
+            __env_t get_env()const noexcept {
+                return __env_t{self->_scope};
+            }
+        };
+
+        bounded_scope* _scope;
+        __ex::connect_result_t<S, __receiver_t> _op;
+
+        __child_op(bounded_scope* scope, S&& sndr):
+            _scope{scope},
+            _op{__ex::connect(std::move(sndr), __receiver_t{this})}
+        {}
+
+        void __done()noexcept {
+            bounded_scope* scope = _scope;
+            this->~__child_op();
+            scope->_pool.deallocate(this, sizeof(__child_op), alignof(__child_op));
+            scope->__release();
+        }
+    };
+
+    template<class S>
+    void __launch(S&& sndr) {
+        using __sender_t = decltype(__ex::starts_on(_ctx.get_scheduler(), std::forward<S>(sndr)));
+        using __op_t = __child_op<__sender_t>;
+        void* p = _pool.allocate(sizeof(__op_t), alignof(__op_t));
+        __op_t* op;
+        try{
+            op = ::new(p) __op_t(this, __ex::starts_on(_ctx.get_scheduler(), std::forward<S>(sndr)));
+        }catch(...){
+            _pool.deallocate(p, sizeof(__op_t), alignof(__op_t));
+            throw;
+        }
+        __ex::start(op->_op);
+    }
+
+    // 子任务结束：空位直接转交给最早的等待者
+    void __release()noexcept {
+        __waiter_base* w = nullptr;
+        {
+            std::lock_guard lk{_mtx};
+            if(_head){
+                w = _head;
+                __unlink(w);
+            }else{
+                --_in_flight;
+                // 持锁通知：join()一旦看到0就可能返回并析构scope
+                _cv.notify_all();
+                return;
+            }
+        }
+        w->_admit(w);
+    }
+
+    void __unlink(__waiter_base* w)noexcept {
+        if(w->_prev)
+            w->_prev->_next = w->_next;
+        else
+            _head = w->_next;
+        if(w->_next)
+            w->_next->_prev = w->_prev;
+        else
+            _tail = w->_prev;
+        w->_next = w->_prev = nullptr;
+        w->_queued = false;
+    }
+
+    template<class S, class R>
+    struct __spawn_op;
+
+    template<class S>
+    struct __spawn_sender;
+
+    asio_context& _ctx;
+    const std::size_t _max;
+    mutable std::mutex _mtx{};
+    std::condition_variable _cv{};
+    std::size_t _in_flight = 0;
+    __waiter_base* _head = nullptr;
+    __waiter_base* _tail = nullptr;
+    __ex::inplace_stop_source _stop_source{};
+    std::pmr::synchronized_pool_resource _pool{};
+};
+
+template<class S, class R>
+struct bounded_scope::__spawn_op: bounded_scope::__waiter_base {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __spawn_op* self;
+        void operator()()noexcept {
+            bool removed = false;
+            {
+                std::lock_guard lk{self->_scope->_mtx};
+                if(self->_queued){
+                    self->_scope->__unlink(self);
+                    removed = true;
+                }
+            }
+            if(removed)
+                __ex::set_stopped(std::move(self->_r));
+        }
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    bounded_scope* _scope;
+    S _sndr;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+
+    template<class _S, class _R>
+    __spawn_op(bounded_scope* scope, _S&& sndr, _R&& r):
+        _scope{scope},
+        _sndr{std::forward<_S>(sndr)},
+        _r{std::forward<_R>(r)}
+    {
+        this->_admit = [](__waiter_base* w)noexcept {
+            auto* self = static_cast<__spawn_op*>(w);
+            self->_stop_callback.reset();
+            self->__run();
+        };
+        this->_cancel = [](__waiter_base* w)noexcept {
+            auto* self = static_cast<__spawn_op*>(w);
+            self->_stop_callback.reset();
+            __ex::set_stopped(std::move(self->_r));
+        };
+    }
+
+    __spawn_op(const __spawn_op&) = delete;
+    __spawn_op(__spawn_op&&) = delete;
+    __spawn_op& operator=(const __spawn_op&) = delete;
+    __spawn_op& operator=(__spawn_op&&) = delete;
+
+    void __run()noexcept {
+        try{
+            _scope->__launch(std::move(_sndr));
+        }catch(...){
+            _scope->__release();
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
+        }
+        __ex::set_value(std::move(_r));
+    }
+
+    void start() & noexcept {
+        if(_scope->_stop_source.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        {
+            std::unique_lock lk{_scope->_mtx};
+            if(_scope->_in_flight < _scope->_max){
+                ++_scope->_in_flight;
+                lk.unlock();
+                _stop_callback.reset();
+                __run();
+                return;
+            }
+            if(!st.stop_requested() && !_scope->_stop_source.stop_requested()){
+                // 空间不足，挂入等待队列
+                this->_queued = true;
+                this->_prev = _scope->_tail;
+                if(_scope->_tail)
+                    _scope->_tail->_next = this;
+                else
+                    _scope->_head = this;
+                _scope->_tail = this;
+                return;
+            }
+        }
+        _stop_callback.reset();
+        __ex::set_stopped(std::move(_r));
+    }
+};
+
+template<class S>
+struct bounded_scope::__spawn_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    bounded_scope* _scope;
+    S _sndr;
+
+    template<__ex::receiver R>
+    auto connect(R&& r) && {
+        return __spawn_op<S, std::decay_t<R>>{ _scope, std::move(_sndr), std::forward<R>(r) };
+    }
+};
+
+template<__ex::sender S>
+auto bounded_scope::spawn(S&& sndr) {
+    return __spawn_sender<std::decay_t<S>>{ this, std::forward<S>(sndr) };
+}
+
+namespace __detail {
+
+struct __task_base {
+    __task_base* _next = nullptr;
+    __task_base* _prev = nullptr;
+    void (*_execute)(__task_base*) noexcept = nullptr;
+};
+
+// 所有者从尾部压入/弹出(LIFO)，窃取者从头部取出(FIFO)
+class __task_deque {
+public:
+    void push_back(__task_base* t)noexcept{
+        std::lock_guard lk{_mtx};
+        t->_next = nullptr;
+        t->_prev = _tail;
+        if(_tail)
+            _tail->_next = t;
+        else
+            _head = t;
+        _tail = t;
+    }
+
+    __task_base* pop_back()noexcept{
+        std::lock_guard lk{_mtx};
+        __task_base* t = _tail;
+        if(t){
+            _tail = t->_prev;
+            if(_tail)
+                _tail->_next = nullptr;
+            else
+                _head = nullptr;
+        }
+        return t;
+    }
+
+    __task_base* pop_front()noexcept{
+        std::lock_guard lk{_mtx};
+        __task_base* t = _head;
+        if(t){
+            _head = t->_next;
+            if(_head)
+                _head->_prev = nullptr;
+            else
+                _tail = nullptr;
+        }
+        return t;
+    }
+private:
+    std::mutex _mtx;
+    __task_base* _head = nullptr;
+    __task_base* _tail = nullptr;
+};
+
+} // namespace __detail
+
+class work_stealing_context {
+public:
+    class scheduler_type;
+    using executor_type = __io::io_context::executor_type;
+
+    explicit work_stealing_context(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())):
+        _guard{std::in_place, __io::make_work_guard(_ctx)},
+        _workers(std::max<std::size_t>(threads, 1))
+    {}
+
+    work_stealing_context(const work_stealing_context&) = delete;
+    work_stealing_context(work_stealing_context&&) = delete;
+    work_stealing_context& operator=(const work_stealing_context&) = delete;
+    work_stealing_context& operator=(work_stealing_context&&) = delete;
+
+    ~work_stealing_context() {
+        join();
+    }
+
+    void start() {
+        _threads.reserve(_workers.size());
+        for(std::size_t i = 0; i < _workers.size(); ++i){
+            _threads.emplace_back([this, i] {
+                __run(i);
+            });
+        }
+    }
+
+    void stop()noexcept {
+        _stopped.store(true, std::memory_order_release);
+        _guard.reset();
+    }
+
+    void join(){
+        stop();
+        for(auto& th: _threads){
+            if(th.joinable())
+                th.join();
+        }
+        _threads.clear();
+    }
+
+    scheduler_type get_scheduler()noexcept;
+
+    executor_type get_executor()noexcept { return _ctx.get_executor(); }
+
+    __io::io_context& context()noexcept { return _ctx; }
+    const __io::io_context& context()const noexcept { return _ctx; }
+private:
+    struct __worker {
+        __detail::__task_deque _tasks;
+    };
+
+    // 每处理若干个任务轮询一次reactor，避免CPU任务饿死IO完成回调
+    static constexpr std::size_t __poll_interval = 32;
+
+    inline static thread_local work_stealing_context* __current_ctx = nullptr;
+    inline static thread_local std::size_t __current_index = 0;
+
+    void __push(__detail::__task_base* t)noexcept {
+        if(__current_ctx == this)
+            _workers[__current_index]._tasks.push_back(t);
+        else
+            _inject.push_back(t);
+        _pending.fetch_add(1, std::memory_order_seq_cst);
+        if(_sleeping.load(std::memory_order_seq_cst) > 0)
+            __wake();
+    }
+
+    __detail::__task_base* __pop(std::size_t index)noexcept {
+        __detail::__task_base* t = _workers[index]._tasks.pop_back();
+        if(!t)
+            t = _inject.pop_front();
+        for(std::size_t i = 1; !t && i < _workers.size(); ++i)
+            t = _workers[(index + i) % _workers.size()]._tasks.pop_front();
+        if(t)
+            _pending.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    void __wake()noexcept {
+        if(_wake_pending.exchange(true, std::memory_order_acq_rel))
+            return;
+        try{
+            __io::post(_ctx, [this]{
+                _wake_pending.store(false, std::memory_order_release);
+            });
+        }catch(...){
+            _wake_pending.store(false, std::memory_order_release);
+        }
+    }
+
+    void __run(std::size_t index) {
+        __current_ctx = this;
+        __current_index = index;
+        std::size_t executed = 0;
+        for(;;){
+            if(__detail::__task_base* t = __pop(index)){
+                // 还有剩余任务且有线程阻塞在reactor中，唤醒一个来窃取
+                if(_pending.load(std::memory_order_relaxed) > 0 && _sleeping.load(std::memory_order_relaxed) > 0)
+                    __wake();
+                t->_execute(t);
+                if(++executed % __poll_interval == 0)
+                    _ctx.poll();
+                continue;
+            }
+            _sleeping.fetch_add(1, std::memory_order_seq_cst);
+            if(_pending.load(std::memory_order_seq_cst) > 0){
+                _sleeping.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+            const std::size_t n = _ctx.run_one();
+            _sleeping.fetch_sub(1, std::memory_order_relaxed);
+            if(n == 0 && _stopped.load(std::memory_order_acquire) && _pending.load(std::memory_order_acquire) == 0)
+                break;
+        }
+        __current_ctx = nullptr;
+    }
+
+    __io::io_context _ctx{};
+    std::optional<__io::executor_work_guard<executor_type>> _guard{};
+    std::vector<__worker> _workers;
+    __detail::__task_deque _inject{};
+    std::atomic<std::size_t> _pending{0};
+    std::atomic<std::size_t> _sleeping{0};
+    std::atomic<bool> _wake_pending{false};
+    std::atomic<bool> _stopped{false};
+    std::vector<std::thread> _threads{};
+};
+
+class work_stealing_context::scheduler_type {
+public:
+    using executor_type = work_stealing_context::executor_type;
+    using scheduler_concept = __ex::scheduler_tag;
+
+    explicit scheduler_type(work_stealing_context& ctx)noexcept:
+        _ctx{&ctx}
+    {}
+
+    bool operator==(const scheduler_type&)const noexcept = default;
+
+    auto schedule() const noexcept {
+        return __schedule_sender_t{ _ctx };
+    }
+
+    executor_type get_executor() const noexcept {
+        return _ctx->get_executor();
+    }
+private:
+    struct __schedule_sender_t {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = __ex::completion_signatures<
+            __ex::set_value_t(),
+            __ex::set_stopped_t()
+        >;
+
+        work_stealing_context* _ctx;
+
+        struct __env_t {
+            work_stealing_context* ctx;
+            template<class CPO>
+            auto query(__ex::get_completion_scheduler_t<CPO>) const noexcept {
+                return scheduler_type{ *ctx };
+            }
+        };
+
+        template<__ex::receiver R>
+        struct __op: __detail::__task_base {
+            using operation_state_concept = __ex::operation_state_tag;
+
+            work_stealing_context* _ctx;
+            R _r;
+
+            template<__ex::receiver _R>
+            __op(work_stealing_context* ctx, _R&& r)noexcept:
+                _ctx{ ctx },
+                _r{ std::forward<_R>(r) }
+            {
+                this->_execute = [](__detail::__task_base* t)noexcept {
+                    __ex::set_value(std::move(static_cast<__op*>(t)->_r));
+                };
+            }
+
+            __op(const __op&) = delete;
+            __op(__op&&) = delete;
+            __op& operator=(const __op&) = delete;
+            __op& operator=(__op&&) = delete;
+
+            void start() & noexcept{
+                if constexpr(!__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
+                    const __ex::stoppable_token auto st = __ex::get_stop_token(__ex::get_env(_r));
+                    if(st.stop_requested()){
+                        __ex::set_stopped(std::move(_r));
+                        return;
+                    }
+                }
+                _ctx->__push(this);
+            }
+        };
+
+        template<__ex::receiver R>
+        auto connect(R&& r) && {
+            return __op<std::decay_t<R>>{ _ctx, std::forward<R>(r) };
+        }
+
+        __env_t get_env() const noexcept {
+            return __env_t{ _ctx };
+        }
+    };
+
+    work_stealing_context* _ctx;
+};
+
+inline work_stealing_context::scheduler_type work_stealing_context::get_scheduler()noexcept {
+    return scheduler_type{*this};
+}
+
+struct task_frame_stats {
+    std::uint64_t allocations = 0;
+    std::uint64_t recycled = 0;
+    std::uint64_t upstream = 0;
+};
+
+namespace __detail {
+
+// 按64字节分级的线程局部空闲链表；asio_context线程上反复创建的协程帧会复用同一块内存
+// 池属于线程而不是某个asio_context，统计数据是整个进程的
+class __frame_pool {
+public:
+    static void* allocate(std::size_t n) {
+        __cache_t& cache = __local();
+        __bump(cache.allocations);
+        const std::size_t c = __class_of(n);
+        if(c < __classes){
+            if(__node_t* node = cache.heads[c]){
+                cache.heads[c] = node->next;
+                --cache.sizes[c];
+                __bump(cache.recycled);
+                return node;
+            }
+            __bump(cache.upstream);
+            return ::operator new((c + 1) * __granularity);
+        }
+        __bump(cache.upstream);
+        return ::operator new(n);
+    }
+
+    static void deallocate(void* p, std::size_t n)noexcept {
+        const std::size_t c = __class_of(n);
+        if(c < __classes){
+            __cache_t& cache = __local();
+            if(cache.sizes[c] < __max_cached){
+                auto* node = static_cast<__node_t*>(p);
+                node->next = cache.heads[c];
+                cache.heads[c] = node;
+                ++cache.sizes[c];
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    // 汇总仍存活线程的计数与已退出线程留下的计数
+    static task_frame_stats stats()noexcept {
+        auto& reg = __registry();
+        std::lock_guard lk{reg.mtx};
+        task_frame_stats st = reg.retired;
+        for(const __cache_t* c = reg.head; c; c = c->next)
+            __accumulate(st, *c);
+        return st;
+    }
+private:
+    static constexpr std::size_t __granularity = 64;
+    static constexpr std::size_t __classes = 64;
+    static constexpr std::uint32_t __max_cached = 256;
+
+    struct __node_t {
+        __node_t* next;
+    };
+
+    struct __cache_t;
+
+    struct __registry_t {
+        std::mutex mtx{};
+        __cache_t* head = nullptr;
+        task_frame_stats retired{};
+    };
+
+    struct __cache_t {
+        std::array<__node_t*, __classes> heads{};
+        std::array<std::uint32_t, __classes> sizes{};
+        // 只由所属线程写入，stats()在其他线程上读取
+        std::atomic<std::uint64_t> allocations{0};
+        std::atomic<std::uint64_t> recycled{0};
+        std::atomic<std::uint64_t> upstream{0};
+        __cache_t* prev = nullptr;
+        __cache_t* next = nullptr;
+
+        __cache_t() {
+            auto& reg = __registry();
+            std::lock_guard lk{reg.mtx};
+            next = reg.head;
+            if(next)
+                next->prev = this;
+            reg.head = this;
+        }
+
+        ~__cache_t() {
+            {
+                auto& reg = __registry();
+                std::lock_guard lk{reg.mtx};
+                __accumulate(reg.retired, *this);
+                if(prev)
+                    prev->next = next;
+                else
+                    reg.head = next;
+                if(next)
+                    next->prev = prev;
+            }
+            for(__node_t* head: heads){
+                while(head)
+                    ::operator delete(std::exchange(head, head->next));
+            }
+        }
+    };
+
+    // 单一写者，不需要原子的读-改-写
+    static void __bump(std::atomic<std::uint64_t>& c)noexcept {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void __accumulate(task_frame_stats& st, const __cache_t& c)noexcept {
+        st.allocations += c.allocations.load(std::memory_order_relaxed);
+        st.recycled += c.recycled.load(std::memory_order_relaxed);
+        st.upstream += c.upstream.load(std::memory_order_relaxed);
+    }
+
+    // 在第一个__cache_t之前构造，因而在所有线程局部缓存之后析构
+    static __registry_t& __registry()noexcept {
+        static __registry_t reg;
+        return reg;
+    }
+
+    static std::size_t __class_of(std::size_t n)noexcept {
+        return (n + __granularity - 1) / __granularity - 1;
+    }
+
+    static __cache_t& __local()noexcept {
+        thread_local __cache_t cache;
+        return cache;
+    }
+
+};
+
+template<class T>
+struct __task_result {
+    std::variant<std::monostate, T, std::exception_ptr> _result{};
+
+    template<class U>
+    void return_value(U&& v) {
+        _result.template emplace<1>(std::forward<U>(v));
+    }
+
+    void unhandled_exception()noexcept {
+        _result.template emplace<2>(std::current_exception());
+    }
+
+    T __get() {
+        if(_result.index() == 2)
+            std::rethrow_exception(std::get<2>(_result));
+        return std::move(std::get<1>(_result));
+    }
+};
+
+template<>
+struct __task_result<void> {
+    std::exception_ptr _error{};
+
+    void return_void()noexcept {}
+
+    void unhandled_exception()noexcept {
+        _error = std::current_exception();
+    }
+
+    void __get() {
+        if(_error)
+            std::rethrow_exception(_error);
+    }
+};
+
+struct __empty_t {};
+
+template<class T>
+struct __task_value_sig {
+    using type = __ex::set_value_t(T);
+};
+
+template<>
+struct __task_value_sig<void> {
+    using type = __ex::set_value_t();
+};
+
+} // namespace __detail
+
+inline task_frame_stats task_frame_statistics()noexcept {
+    return __detail::__frame_pool::stats();
+}
+
+// 协程帧从线程局部池中分配；每次co_await之后回到启动它的调度器上
+template<class T, class Scheduler = asio_context::scheduler_type>
+class basic_task {
+public:
+    struct promise_type;
+    using __handle_t = std::coroutine_handle<promise_type>;
+
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        typename __detail::__task_value_sig<T>::type,
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    static constexpr bool __is_scheduler_affine = true;
+
+    basic_task(basic_task&& other)noexcept:
+        _h{std::exchange(other._h, {})}
+    {}
+
+    basic_task& operator=(basic_task&& other)noexcept {
+        if(this != &other){
+            if(_h)
+                _h.destroy();
+            _h = std::exchange(other._h, {});
+        }
+        return *this;
+    }
+
+    ~basic_task() {
+        if(_h)
+            _h.destroy();
+    }
+
+    struct promise_type: __detail::__task_result<T> {
+        static void* operator new(std::size_t n) {
+            return __detail::__frame_pool::allocate(n);
+        }
+
+        static void operator delete(void* p, std::size_t n)noexcept {
+            __detail::__frame_pool::deallocate(p, n);
+        }
+
+        struct __final_awaiter {
+            bool await_ready()const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(__handle_t h)noexcept {
+                promise_type& p = h.promise();
+                return p._on_complete(p._parent);
+            }
+
+            void await_resume()const noexcept {}
+        };
+
+        struct __env_t {
+            const promise_type* p;
+
+            Scheduler query(__ex::get_scheduler_t)const noexcept {
+                return *p->_sched;
+            }
+
+            __ex::inplace_stop_token query(__ex::get_stop_token_t)const noexcept {
+                return p->_stop_token;
+            }
+        };
+
+        basic_task get_return_object()noexcept {
+            return basic_task{__handle_t::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()const noexcept { return {}; }
+
+        __final_awaiter final_suspend()const noexcept { return {}; }
+
+        __env_t get_env()const noexcept {
+            return __env_t{this};
+        }
+
+        std::coroutine_handle<> unhandled_stopped()noexcept {
+            return _on_stopped(_parent);
+        }
+
+        template<class A>
+        decltype(auto) await_transform(A&& a) {
+            if constexpr(requires { requires std::decay_t<A>::__is_scheduler_affine; }){
+                if constexpr(requires { std::forward<A>(a).operator co_await(); })
+                    return std::forward<A>(a);
+                else
+                    return __ex::as_awaitable(std::forward<A>(a), *this);
+            }else if constexpr(__ex::sender<A>){
+                return __ex::as_awaitable(__ex::continues_on(std::forward<A>(a), *_sched), *this);
+            }else{
+                return std::forward<A>(a);
+            }
+        }
+
+        std::optional<Scheduler> _sched{};
+        __ex::inplace_stop_token _stop_token{};
+        void* _parent = nullptr;
+        std::coroutine_handle<> (*_on_complete)(void*) noexcept = nullptr;
+        std::coroutine_handle<> (*_on_stopped)(void*) noexcept = nullptr;
+    };
+
+    struct __awaiter {
+        __handle_t _h;
+
+        bool await_ready()const noexcept { return false; }
+
+        template<class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent)noexcept {
+            promise_type& p = _h.promise();
+            p._parent = parent.address();
+            p._on_complete = [](void* a)noexcept -> std::coroutine_handle<> {
+                return std::coroutine_handle<>::from_address(a);
+            };
+            p._on_stopped = [](void* a)noexcept -> std::coroutine_handle<> {
+                return std::coroutine_handle<Promise>::from_address(a).promise().unhandled_stopped();
+            };
+            const auto& env = __ex::get_env(parent.promise());
+            p._sched.emplace(__ex::get_scheduler(env));
+            if constexpr(std::is_convertible_v<__ex::stop_token_of_t<decltype(env)>, __ex::inplace_stop_token>)
+                p._stop_token = __ex::get_stop_token(env);
+            return _h;
+        }
+
+        T await_resume() {
+            return _h.promise().__get();
+        }
+    };
+
+    __awaiter operator co_await() && noexcept {
+        return __awaiter{_h};
+    }
+
+    template<class R>
+    struct __op {
+        using operation_state_concept = __ex::operation_state_tag;
+        using __token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+
+        struct __forward_stop {
+            __ex::inplace_stop_source* source;
+            void operator()()noexcept {
+                source->request_stop();
+            }
+        };
+
+        // 接收者的停止令牌不是inplace_stop_token时转发到自己的stop_source
+        struct __forwarding_t {
+            __ex::inplace_stop_source source{};
+            std::optional<typename __token_t::template callback_type<__forward_stop>> callback{};
+        };
+
+        static constexpr bool __needs_forwarding =
+            !std::is_same_v<__token_t, __ex::inplace_stop_token> && !__ex::unstoppable_token<__token_t>;
+
+        __handle_t _h;
+        R _r;
+        [[no_unique_address]] std::conditional_t<__needs_forwarding, __forwarding_t, __detail::__empty_t> _forwarding{};
+
+        template<class _R>
+        __op(__handle_t h, _R&& r)noexcept:
+            _h{h},
+            _r{std::forward<_R>(r)}
+        {}
+
+        __op(const __op&) = delete;
+        __op(__op&&) = delete;
+        __op& operator=(const __op&) = delete;
+        __op& operator=(__op&&) = delete;
+
+        ~__op() {
+            if(_h)
+                _h.destroy();
+        }
+
+        void __complete()noexcept {
+            if constexpr(__needs_forwarding)
+                _forwarding.callback.reset();
+            try{
+                if constexpr(std::is_void_v<T>){
+                    _h.promise().__get();
+                    std::exchange(_h, {}).destroy();
+                    __ex::set_value(std::move(_r));
+                }else{
+                    T value = _h.promise().__get();
+                    std::exchange(_h, {}).destroy();
+                    __ex::set_value(std::move(_r), std::move(value));
+                }
+            }catch(...){
+                std::exchange(_h, {}).destroy();
+                __ex::set_error(std::move(_r), std::current_exception());
+            }
+        }
+
+        void __stopped()noexcept {
+            if constexpr(__needs_forwarding)
+                _forwarding.callback.reset();
+            std::exchange(_h, {}).destroy();
+            __ex::set_stopped(std::move(_r));
+        }
+
+        void start() & noexcept {
+            promise_type& p = _h.promise();
+            p._parent = this;
+            p._on_complete = [](void* a)noexcept -> std::coroutine_handle<> {
+                static_cast<__op*>(a)->__complete();
+                return std::noop_coroutine();
+            };
+            p._on_stopped = [](void* a)noexcept -> std::coroutine_handle<> {
+                static_cast<__op*>(a)->__stopped();
+                return std::noop_coroutine();
+            };
+            const auto& env = __ex::get_env(_r);
+            p._sched.emplace(__ex::get_scheduler(env));
+            if constexpr(std::is_same_v<__token_t, __ex::inplace_stop_token>){
+                p._stop_token = __ex::get_stop_token(env);
+            }else if constexpr(__needs_forwarding){
+                _forwarding.callback.emplace(__ex::get_stop_token(env), __forward_stop{&_forwarding.source});
+                p._stop_token = _forwarding.source.get_token();
+            }
+            _h.resume();
+        }
+    };
+
+    template<__ex::receiver R>
+        requires requires (const __ex::env_of_t<R>& env) {
+            { __ex::get_scheduler(env) } -> std::convertible_to<Scheduler>;
+        }
+    auto connect(R&& r) && {
+        return __op<std::decay_t<R>>{ std::exchange(_h, {}), std::forward<R>(r) };
+    }
+private:
+    explicit basic_task(__handle_t h)noexcept:
+        _h{h}
+    {}
+
+    __handle_t _h;
+};
+
+template<class T = void>
+using task = basic_task<T>;
+
+template <bool TypeErased = false>
+struct basic_use_sender_t
+{
+    constexpr basic_use_sender_t() {}
+
+    // use_any_sender(resource)：类型擦除时放不进内联缓冲区的发起对象从resource分配
+    // 发起对象在连接之前就已创建，此时还没有接收者环境可以查询
+    constexpr basic_use_sender_t operator()(std::pmr::memory_resource* resource)const noexcept requires TypeErased {
+        basic_use_sender_t token;
+        token._resource = resource;
+        return token;
+    }
+
+    std::pmr::memory_resource* resource()const noexcept requires TypeErased {
+        return _resource ? _resource : std::pmr::get_default_resource();
+    }
+
+    template<class InnerExecutor>
+    struct executor_with_default : InnerExecutor
+    {
+        using default_completion_token_type = basic_use_sender_t;
+
+        executor_with_default(const InnerExecutor& ex)noexcept : InnerExecutor(ex) {}
+
+        template<class _InnerExecutor>
+            requires (!std::is_same_v<_InnerExecutor, executor_with_default> && std::is_convertible_v<_InnerExecutor, InnerExecutor>)
+        executor_with_default(const _InnerExecutor& ex)noexcept : InnerExecutor(ex) {}
+    };
+
+    template<class T>
+    using as_default_on_t = typename T::template rebind_executor<
+        executor_with_default<typename T::executor_type>
+    >::other;
+
+    template<class T>
+    static typename std::decay_t<T>::template rebind_executor<
+        executor_with_default<typename std::decay_t<T>::executor_type>
+    >::other
+        as_default_on(T&& obj)
+    {
+        return typename std::decay_t<T>::template rebind_executor<
+            executor_with_default<typename std::decay_t<T>::executor_type>
+        >::other(std::forward<T>(obj));
+    }
+private:
+    [[no_unique_address]] std::conditional_t<TypeErased, std::pmr::memory_resource*, std::monostate> _resource{};
+};
+
+using use_sender_t = basic_use_sender_t<false>;
+using use_any_sender_t = basic_use_sender_t<true>;
+
+inline constexpr use_sender_t use_sender{};
+inline constexpr use_any_sender_t use_any_sender{};
+
+#if defined(ASIO_TO_EXEC_HAS_DEFERRED)
+// 把多步asio操作融合成一个sender：first是以deferred发起的操作，
+// 每个step以上一步的完成参数调用，返回下一个deferred操作(纯计算步骤可返回deferred.values(...))
+// 整条链只有一个操作状态：停止回调只登记一次，各步骤的处理器复用同一块SBO内存
+// 等价于 (first | deferred(steps)...)(use_sender)
+template<class First, class ...Steps>
+auto fuse(First&& first, Steps&& ...steps) {
+    return (std::forward<First>(first) | ... | __io::deferred(std::forward<Steps>(steps)))(use_sender);
+}
+#endif
+
+namespace __detail {
+
+template<class ...Sigs>
+struct __one_bridge_signature {
+    static_assert(sizeof...(Sigs) == 0, "as_async_op requires a sender with at most one set_value signature");
+    using type = void(std::exception_ptr);
+};
+
+template<class Sig>
+struct __one_bridge_signature<Sig> {
+    using type = Sig;
+};
+
+template<class ...Ts>
+using __bridge_signature = void(std::exception_ptr, std::decay_t<Ts>...);
+
+template<class ...Sigs>
+using __one_bridge_signature_t = typename __one_bridge_signature<Sigs...>::type;
+
+struct __bridge_env {
+    __ex::inplace_stop_token _token;
+
+    __ex::inplace_stop_token query(__ex::get_stop_token_t)const noexcept {
+        return _token;
+    }
+};
+
+template<class Sender>
+using __bridge_signature_t = __ex::value_types_of_t<Sender, __bridge_env, __bridge_signature, __one_bridge_signature_t>;
+
+template<class Executor>
+bool __running_in_this_thread(const Executor& ex)noexcept {
+    if constexpr(requires { ex.running_in_this_thread(); }){
+        return ex.running_in_this_thread();
+    }else if constexpr(requires { ex.template target<__io::io_context::executor_type>(); }){
+        const auto* p = ex.template target<__io::io_context::executor_type>();
+        return p && p->running_in_this_thread();
+    }else{
+        return false;
+    }
+}
+
+// 处理器使用默认分配器时与asio自身的操作一样改用线程本地的回收分配器
+template<class Handler>
+using __handler_allocator_t = std::conditional_t<
+    std::is_same_v<__io::associated_allocator_t<Handler>, std::allocator<void>>,
+    __io::recycling_allocator<void>,
+    __io::associated_allocator_t<Handler>
+>;
+
+template<class Handler>
+__handler_allocator_t<Handler> __handler_allocator(const Handler& h)noexcept {
+    if constexpr(std::is_same_v<__io::associated_allocator_t<Handler>, std::allocator<void>>)
+        return {};
+    else
+        return __io::get_associated_allocator(h);
+}
+
+template<class Sender, class Handler, class Signature>
+struct __bridge_op;
+
+// 操作状态由处理器关联的分配器分配，在调用处理器之前释放
+template<class Sender, class Handler, class ...Ts>
+struct __bridge_op<Sender, Handler, void(std::exception_ptr, Ts...)> {
+    using __alloc_t = typename std::allocator_traits<__handler_allocator_t<Handler>>::template rebind_alloc<__bridge_op>;
+    using __traits_t = std::allocator_traits<__alloc_t>;
+    using __executor_t = __io::associated_executor_t<Handler>;
+    using __work_t = __io::executor_work_guard<__executor_t>;
+
+    struct __receiver {
+        using receiver_concept = __ex::receiver_t;
+
+        __bridge_op* self;
+
+        template<class ...Vs>
+        void set_value(Vs&& ...vs)&& noexcept {
+            self->__set(std::exception_ptr{}, std::forward<Vs>(vs)...);
+        }
+
+        template<class E>
+        void set_error(E&& e)&& noexcept {
+            if constexpr(std::is_same_v<std::decay_t<E>, std::exception_ptr>)
+                self->__set(std::forward<E>(e), Ts{}...);
+            else if constexpr(std::is_same_v<std::decay_t<E>, __error_code>)
+                self->__set(std::make_exception_ptr(__system_error{e}), Ts{}...);
+            else
+                self->__set(std::make_exception_ptr(std::forward<E>(e)), Ts{}...);
+        }
+
+        void set_stopped()&& noexcept {
+            self->__set(std::make_exception_ptr(__system_error{__io::error::operation_aborted}), Ts{}...);
+        }
+
+        __bridge_env get_env()const noexcept {
+            return __bridge_env{ self->_stop.get_token() };
+        }
+    };
+
+    struct __cancel_t {
+        __bridge_op* self;
+        void operator()(__io::cancellation_type_t)noexcept {
+            self->_stop.request_stop();
+        }
+    };
+
+    Handler _handler;
+    __work_t _work;
+    __ex::inplace_stop_source _stop{};
+    std::optional<std::tuple<std::exception_ptr, Ts...>> _result{};
+    // 发起线程与完成者都到达后才调用处理器
+    std::atomic<int> _arrivals{0};
+    __ex::connect_result_t<Sender, __receiver> _op;
+
+    template<class S, class H>
+    __bridge_op(S&& sndr, H&& handler):
+        _handler{std::forward<H>(handler)},
+        _work{__io::get_associated_executor(_handler)},
+        _op{__ex::connect(std::forward<S>(sndr), __receiver{this})}
+    {}
+
+    __bridge_op(__bridge_op&&) = delete;
+
+    // 投递到处理器执行器上的函数只持有指针，post失败时操作状态仍然完整
+    struct __upcall {
+        using allocator_type = __io::associated_allocator_t<Handler>;
+
+        __bridge_op* self;
+
+        allocator_type get_allocator()const noexcept {
+            return __io::get_associated_allocator(self->_handler);
+        }
+
+        void operator()() {
+            self->__invoke();
+        }
+    };
+
+    // 在发起函数内完成时post失败，异常经async_initiate抛给调用方，处理器不会被调用
+    void __start() {
+        auto slot = __io::get_associated_cancellation_slot(_handler);
+        if(slot.is_connected())
+            slot.template emplace<__cancel_t>(this);
+        __ex::start(_op);
+        if(_arrivals.fetch_add(1, std::memory_order_acq_rel) != 1)
+            return;
+        // 必须post，避免在发起者的栈上调用处理器
+        try{
+            __io::post(_work.get_executor(), __upcall{this});
+        }catch(...){
+            __destroy();
+            throw;
+        }
+    }
+
+    template<class ...Vs>
+    void __set(std::exception_ptr e, Vs&& ...vs)noexcept {
+        _result.emplace(std::move(e), std::forward<Vs>(vs)...);
+        if(_arrivals.fetch_add(1, std::memory_order_acq_rel) != 1)
+            return;
+        if(__running_in_this_thread(_work.get_executor())){
+            __invoke();
+            return;
+        }
+        try{
+            __io::post(_work.get_executor(), __upcall{this});
+        }catch(...){
+            // 无法投递时只能在当前线程上调用处理器，仍交付原本的结果
+            __invoke();
+        }
+    }
+
+    void __release_slot()noexcept {
+        auto slot = __io::get_associated_cancellation_slot(_handler);
+        if(slot.is_connected())
+            slot.clear();
+    }
+
+    void __destroy()noexcept {
+        __release_slot();
+        __alloc_t alloc{__handler_allocator(_handler)};
+        __traits_t::destroy(alloc, this);
+        __traits_t::deallocate(alloc, this, 1);
+    }
+
+    // 先释放操作状态再调用处理器
+    void __invoke() {
+        __release_slot();
+        __alloc_t alloc{__handler_allocator(_handler)};
+        Handler handler{std::move(_handler)};
+        std::tuple<std::exception_ptr, Ts...> args{std::move(*_result)};
+        __work_t work{std::move(_work)};
+        __traits_t::destroy(alloc, this);
+        __traits_t::deallocate(alloc, this, 1);
+        std::apply(std::move(handler), std::move(args));
+    }
+};
+
+struct __bridge_initiation {
+    template<class Handler, class Sender>
+    void operator()(Handler&& handler, Sender&& sndr)const {
+        using __op_t = __bridge_op<
+            std::decay_t<Sender>,
+            std::decay_t<Handler>,
+            __bridge_signature_t<std::decay_t<Sender>>
+        >;
+        typename __op_t::__alloc_t alloc{__handler_allocator(handler)};
+        __op_t* op = __op_t::__traits_t::allocate(alloc, 1);
+        try{
+            __op_t::__traits_t::construct(alloc, op, std::forward<Sender>(sndr), std::forward<Handler>(handler));
+        }catch(...){
+            __op_t::__traits_t::deallocate(alloc, op, 1);
+            throw;
+        }
+        op->__start();
+    }
+};
+
+}// namespace __detail
+
+// 把sender当作asio异步操作启动，完成签名为void(std::exception_ptr, Ts...)，
+// set_error与set_stopped以异常报告，此时Ts为值初始化
+// 操作状态由处理器关联的分配器分配；关联的取消槽映射为sender的停止令牌；处理器在其关联的执行器上调用
+template<__ex::sender S, class CompletionToken>
+auto as_async_op(S&& sndr, CompletionToken&& token) {
+    using __signature_t = __detail::__bridge_signature_t<std::decay_t<S>>;
+    return __io::async_initiate<CompletionToken, __signature_t>(
+        __detail::__bridge_initiation{},
+        token,
+        std::forward<S>(sndr)
+    );
+}
+
+namespace __detail {
+
+template<class ...Args>
+struct __op_base{
+    __op_base() = default;
+    __op_base(const __op_base&) = delete;
+    __op_base(__op_base&&) = delete;
+    __op_base& operator=(const __op_base&) = delete;
+    __op_base& operator=(__op_base&&) = delete;
+    virtual void complete(Args ...args)noexcept{};
+};
+
+template<class ...Args>
+struct use_sender_handler_base {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    __op_base<Args...>* op;
+    allocator_type allocator;
+
+    allocator_type get_allocator() const noexcept { return allocator; }
 
     template<class ..._Args>
     void operator()(_Args&& ...args) {
@@ -334,586 +2657,4756 @@ struct use_sender_handler_base {
     }
 };
 
-template<class ...Args>
-struct use_sender_handler: use_sender_handler_base<Args...> {
-    using cancellation_slot_type = __io::cancellation_slot;
-    cancellation_slot_type slot;
-    cancellation_slot_type get_cancellation_slot() const noexcept { return slot; }
+template<class ...Args>
+struct use_sender_handler: use_sender_handler_base<Args...> {
+    using cancellation_slot_type = __io::cancellation_slot;
+    cancellation_slot_type slot;
+    cancellation_slot_type get_cancellation_slot() const noexcept { return slot; }
+};
+
+// Copyright Ruslan Arutyunyan, 2019-2021.
+// Copyright Antony Polukhin, 2021-2023.
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Contributed by Ruslan Arutyunyan
+
+template <std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
+class basic_any{
+    static_assert(OptimizeForSize > 0 && OptimizeForAlignment > 0, "Size and Align shall be positive values");
+    static_assert(OptimizeForSize >= OptimizeForAlignment, "Size shall non less than Align");
+    static_assert((OptimizeForAlignment & (OptimizeForAlignment - 1)) == 0, "Align shall be a power of 2");
+    static_assert(OptimizeForSize % OptimizeForAlignment == 0, "Size shall be multiple of alignment");
+private:
+    /// @cond
+    enum operation{
+        Destroy,
+        Move,
+        UnsafeCast
+    };
+
+    template <typename ValueType>
+    static void* small_manager(operation op, basic_any& left, const basic_any* right){
+        switch (op)
+        {
+            case Destroy:
+                reinterpret_cast<ValueType*>(&left.content.small_value)->~ValueType();
+                break;
+            case Move: {
+                ValueType* value = reinterpret_cast<ValueType*>(&const_cast<basic_any*>(right)->content.small_value);
+                new (&left.content.small_value) ValueType(std::move(*value));
+                left.man = right->man;
+                reinterpret_cast<ValueType const*>(&right->content.small_value)->~ValueType();
+                const_cast<basic_any*>(right)->man = 0;
+            };
+                break;
+            case UnsafeCast:
+                return reinterpret_cast<typename std::remove_cv<ValueType>::type *>(&left.content.small_value);
+        }
+        return 0;
+    }
+
+    template <typename ValueType>
+    static void* large_manager(operation op, basic_any& left, const basic_any* right){
+        switch (op)
+        {
+            case Destroy:
+                std::pmr::polymorphic_allocator<>{left.resource}.delete_object(static_cast<ValueType*>(left.content.large_value));
+                break;
+            case Move:
+                left.content.large_value = right->content.large_value;
+                left.resource = right->resource;
+                left.man = right->man;
+                const_cast<basic_any*>(right)->content.large_value = 0;
+                const_cast<basic_any*>(right)->man = 0;
+                break;
+            case UnsafeCast:
+                return reinterpret_cast<typename std::remove_cv<ValueType>::type *>(left.content.large_value);
+        }
+        return 0;
+    }
+
+    template <typename ValueType>
+    struct is_small_object : std::integral_constant<bool, sizeof(ValueType) <= OptimizeForSize &&
+        alignof(ValueType) <= OptimizeForAlignment &&
+        std::is_nothrow_move_constructible<ValueType>::value>
+    {};
+
+    template <typename ValueType>
+    static void create(basic_any& any, ValueType&& value, std::true_type){
+        typedef typename std::decay<const ValueType>::type DecayedType;
+        any.man = &small_manager<DecayedType>;
+        new (&any.content.small_value) DecayedType(std::forward<ValueType>(value));
+    }
+
+    template <typename ValueType>
+    static void create(basic_any& any, ValueType&& value, std::false_type){
+        typedef typename std::decay<const ValueType>::type DecayedType;
+        any.man = &large_manager<DecayedType>;
+        any.content.large_value = std::pmr::polymorphic_allocator<>{any.resource}.new_object<DecayedType>(std::forward<ValueType>(value));
+    }
+    /// @endcond
+
+public: // non-type template parameters accessors
+        static constexpr std::size_t buffer_size = OptimizeForSize;
+        static constexpr std::size_t buffer_align = OptimizeForAlignment;
+
+public: // structors
+
+    /// \post this->empty() is true.
+    constexpr basic_any() noexcept
+        : man(0), content()
+    {
+    }
+
+    basic_any(basic_any&& other) noexcept
+        : man(0), content()
+    {
+        if (other.man){
+            other.man(Move, *this, &other);
+        }
+    }
+
+    template<typename ValueType>
+    basic_any(ValueType&& value
+        , typename std::enable_if<!std::is_same<basic_any&, ValueType>::value >::type* = 0 // disable if value has type `basic_any&`
+        , typename std::enable_if<!std::is_const<ValueType>::value >::type* = 0) // disable if value has type `const ValueType&&`
+        : man(0), content(){
+        typedef typename std::decay<ValueType>::type DecayedType;
+        static_assert(
+            !std::is_same<DecayedType, basic_any>::value,
+            "basic_any shall not be constructed from basic_any"
+        );
+        create(*this, static_cast<ValueType&&>(value), is_small_object<DecayedType>());
+    }
+
+    /// Same as above, but a large value is allocated from `resource`.
+    template<typename ValueType>
+    basic_any(std::allocator_arg_t, std::pmr::memory_resource* mr, ValueType&& value)
+        : man(0), content(), resource(mr){
+        typedef typename std::decay<ValueType>::type DecayedType;
+        static_assert(
+            !std::is_same<DecayedType, basic_any>::value,
+            "basic_any shall not be constructed from basic_any"
+        );
+        create(*this, static_cast<ValueType&&>(value), is_small_object<DecayedType>());
+    }
+
+    ~basic_any() noexcept{
+        if (man){
+            man(Destroy, *this, 0);
+        }
+    }
+
+public: // modifiers
+    basic_any & swap(basic_any & rhs) noexcept{
+        if (this == &rhs){
+            return *this;
+        }
+
+        if (man && rhs.man){
+            basic_any tmp;
+            rhs.man(Move, tmp, &rhs);
+            man(Move, rhs, this);
+            tmp.man(Move, *this, &tmp);
+        }
+        else if (man){
+            man(Move, rhs, this);
+        }
+        else if (rhs.man){
+            rhs.man(Move, *this, &rhs);
+        }
+        return *this;
+    }
+
+    basic_any & operator=(basic_any&& rhs) noexcept{
+        rhs.swap(*this);
+        basic_any().swap(rhs);
+        return *this;
+    }
+
+    template <class ValueType>
+    basic_any & operator=(ValueType&& rhs){
+        typedef typename std::decay<ValueType>::type DecayedType;
+        static_assert(
+            !std::is_same<DecayedType, basic_any>::value,
+            "basic_any shall not be assigned into basic_any"
+        );
+        basic_any(std::forward<ValueType>(rhs)).swap(*this);
+        return *this;
+    }
+
+public: // queries
+    bool empty() const noexcept{
+        return !man;
+    }
+
+    /// \post this->empty() is true
+    void clear() noexcept{
+        basic_any().swap(*this);
+    }
+
+private: // representation
+
+    template<typename ValueType, std::size_t Size, std::size_t Alignment>
+    friend ValueType * unsafe_any_cast(basic_any<Size, Alignment> *) noexcept;
+
+    typedef void*(*manager)(operation op, basic_any& left, const basic_any* right);
+
+    manager man;
+
+    union content {
+        void * large_value;
+        alignas(OptimizeForAlignment) unsigned char small_value[OptimizeForSize];
+    } content;
+
+    // large_value的来源
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    /// @endcond
+};
+
+/// Exchange of the contents of `lhs` and `rhs`.
+/// \throws Nothing.
+template<std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
+inline void swap(basic_any<OptimizeForSize, OptimizeForAlignment>& lhs, basic_any<OptimizeForSize, OptimizeForAlignment>& rhs) noexcept{
+    lhs.swap(rhs);
+}
+
+template<typename ValueType, std::size_t OptimizedForSize, std::size_t OptimizeForAlignment>
+inline ValueType * unsafe_any_cast(basic_any<OptimizedForSize, OptimizeForAlignment> * operand) noexcept{
+    return static_cast<ValueType*>(operand->man(basic_any<OptimizedForSize, OptimizeForAlignment>::UnsafeCast, *operand, 0));
+}
+
+template<typename ValueType, std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
+inline const ValueType * unsafe_any_cast(const basic_any<OptimizeForSize, OptimizeForAlignment> * operand) noexcept{
+    return unsafe_any_cast<ValueType>(const_cast<basic_any<OptimizeForSize, OptimizeForAlignment> *>(operand));
+}
+
+template <class Init, class ...InitArgs>
+struct __initializer {
+    template<class _Init, class ..._InitArgs>
+    explicit __initializer(_Init&& init, _InitArgs&& ...args):
+        _init{std::forward<_Init>(init)},
+        _args{std::forward<_InitArgs>(args)...}
+    {}
+
+    __initializer(const __initializer&) = delete;
+    __initializer(__initializer&&) = default;
+    __initializer& operator=(const __initializer&) = delete;
+    __initializer& operator=(__initializer&&) = default;
+
+    template <class Handler>
+    void operator()(Handler&& h) && {
+        std::apply([this, h = std::forward<Handler>(h)](InitArgs&& ...args) mutable {
+            std::move(_init)(std::move(h), std::move(args)...);
+        }, std::move(_args));
+    }
+
+    auto get_executor()const noexcept requires requires (const Init& i) { i.get_executor(); } {
+        return _init.get_executor();
+    }
+private:
+    Init _init;
+    std::tuple<InitArgs...> _args;
+};
+
+// asio操作的跟踪事件名：已知发起类型时用它的名字，类型被擦除时用完成签名
+template<class Init, class ...Args>
+struct __op_trace_name {
+    static constexpr const char* value = __type_name<void(Args...)>::value;
+};
+
+template<class Initiation, class ...InitArgs, class ...Args>
+struct __op_trace_name<__initializer<Initiation, InitArgs...>, Args...> {
+    static constexpr const char* value = __type_name<Initiation>::value;
+};
+
+template<class ...Args>
+struct __any_initializer{
+    using __any_t = basic_any<512, alignof(std::max_align_t)>;
+private:
+    struct __init_base{
+        virtual void init(use_sender_handler_base<Args...>&&) = 0;
+        virtual void init(use_sender_handler<Args...>&&) = 0;
+    };
+
+    template<class Init, class ...InitArgs>
+    struct __init_impl final: __init_base{
+        template<class _Init, class ..._InitArgs>
+        __init_impl(_Init&& init, _InitArgs&& ...args):
+            _init(std::forward<_Init>(init), std::forward<_InitArgs>(args)...)
+        {}
+
+        __init_impl(const __init_impl&) = delete;
+        __init_impl& operator=(const __init_impl&) = delete;
+        __init_impl(__init_impl&&)noexcept = default;
+        __init_impl& operator=(__init_impl&&)noexcept = default;
+
+        void init(use_sender_handler_base<Args...>&& handler) override{
+            std::move(_init)(std::move(handler));
+        }
+
+        void init(use_sender_handler<Args...>&& handler) override{
+            std::move(_init)(std::move(handler));
+        }
+    private:
+        __initializer<Init, InitArgs...> _init;
+    };
+public:
+    template<class Init, class ...InitArgs>
+    __any_initializer(std::allocator_arg_t, std::pmr::memory_resource* resource, Init&& init, InitArgs&& ...args):
+        _data{std::allocator_arg, resource, __init_impl<std::decay_t<Init>, std::decay_t<InitArgs>...>(std::forward<Init>(init), std::forward<InitArgs>(args)...)}
+    {}
+
+    template<class Init, class ...InitArgs>
+        requires (!std::is_same_v<std::decay_t<Init>, std::allocator_arg_t>)
+    __any_initializer(Init&& init, InitArgs&& ...args):
+        __any_initializer(std::allocator_arg, std::pmr::get_default_resource(), std::forward<Init>(init), std::forward<InitArgs>(args)...)
+    {}
+
+    __any_initializer(const __any_initializer&) = delete;
+    __any_initializer& operator=(const __any_initializer&) = delete;
+    __any_initializer(__any_initializer&&)noexcept = default;
+    __any_initializer& operator=(__any_initializer&&)noexcept = default;
+
+    void operator()(use_sender_handler_base<Args...>&& handler){
+        unsafe_any_cast<__init_base>(&_data)->init(std::move(handler));
+    }
+
+    void operator()(use_sender_handler<Args...>&& handler){
+        unsafe_any_cast<__init_base>(&_data)->init(std::move(handler));
+    }
+private:
+    __any_t _data;
+};
+
+template<class T>
+concept __is_tuple = requires (T&& t){
+    std::get<0>(t);
+};
+
+template<class T>
+constexpr decltype(auto) __unwrap_first(T&& t)noexcept{
+    return std::forward<T>(t);
+}
+
+template<__is_tuple T>
+constexpr decltype(auto) __unwrap_first(T&& t)noexcept{
+    return __unwrap_first(std::get<0>(std::forward<T>(t)));
+}
+
+template<class T>
+using __unwrap_first_t = std::decay_t<decltype(__unwrap_first(std::declval<T>()))>;
+
+template<__is_tuple T>
+constexpr decltype(auto) __unwrap_tuple(T&& t)noexcept{
+    if constexpr(std::tuple_size<T>{} == size_t(1)){
+        return __unwrap_tuple(std::get<0>(std::forward<T>(t)));
+    }else{
+        return std::forward<T>(t);
+    }
+}
+
+template<class T>
+constexpr decltype(auto) __unwrap_tuple(T&& t)noexcept{
+    return std::make_tuple(std::forward<T>(t));
+}
+
+template<class A, class B>
+bool __same_executor(const A& a, const B& b)noexcept {
+    if constexpr(std::equality_comparable_with<A, B>){
+        return a == b;
+    }else if constexpr(requires { b.template target<A>(); }){
+        const A* p = b.template target<A>();
+        return p && *p == a;
+    }else if constexpr(requires { a.template target<B>(); }){
+        const B* p = a.template target<B>();
+        return p && *p == b;
+    }else{
+        return false;
+    }
+}
+
+template<class ...Args>
+struct __await_value {
+    using type = std::tuple<Args...>;
+};
+
+template<class Arg>
+struct __await_value<Arg> {
+    using type = Arg;
+};
+
+// 让不可移动的操作状态可以通过optional::emplace原地构造
+template<class F>
+struct __conv {
+    F f;
+
+    operator std::invoke_result_t<F>() && {
+        return std::move(f)();
+    }
+};
+
+template<class F>
+__conv(F) -> __conv<F>;
+
+template<class Init, class ...Args>
+struct __sender{
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(Args...),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+    using initializer_type = Init;
+
+    __sender(initializer_type&& init) noexcept:
+        _init(std::move(init))
+    {}
+
+    __sender(__sender&&) = default;
+    __sender& operator=(__sender&&) = default;
+
+    initializer_type _init;
+
+    template<__ex::receiver R>
+    struct __operation_base: __op_base<Args...> {
+        using operation_state_concept = __ex::operation_state_tag;
+
+        using __storage_t = std::variant<
+            initializer_type,
+            __sbo_buffer<512>
+        >;
+
+        static constexpr const char* __trace_name = __op_trace_name<initializer_type, Args...>::value;
+
+        __storage_t _storage;
+        R _r;
+        __metrics_handle _metrics{__metrics_handle::__current()};
+        __stamp _started_at{};
+
+        __operation_base(initializer_type&& i, R&& r):
+            _storage{std::move(i)}, _r{std::move(r)}
+        {}
+
+        initializer_type& __get_initializer()noexcept{
+            return std::get<0>(_storage);
+        }
+
+        __sbo_buffer<512>& __emplace_buffer()noexcept{
+            return _storage.template emplace<1>(__env_resource(__ex::get_env(_r)));
+        }
+
+        void __stop()noexcept{
+            __with_metrics(_metrics, [](context_metrics& m){ m.__on_stopped(); });
+            __trace(this, __trace_name, __trace_phase::stopped);
+            __ex::set_stopped(std::move(_r));
+        }
+
+        void __error()noexcept{
+            __ex::set_error(std::move(_r), std::current_exception());
+        }
+
+        void __on_start()noexcept{
+            __trace(this, __trace_name, __trace_phase::start);
+        }
+
+        void __on_initiate()noexcept{
+            _started_at.__mark();
+            __trace(this, __trace_name, __trace_phase::initiate);
+        }
+
+        void __init(){
+            __on_initiate();
+            auto initializer{std::move(__get_initializer())};
+            std::move(initializer)(use_sender_handler_base<Args...>{
+                .op{this},
+                .allocator{&__emplace_buffer()}
+            });
+        }
+
+        void complete(Args ...args)noexcept override{
+            __with_metrics(_metrics, [this](context_metrics& m){
+                m.__on_io_complete(_started_at.__elapsed());
+            });
+            __trace(this, __trace_name, __trace_phase::complete);
+            if constexpr (sizeof...(args) == 0) {
+                __ex::set_value(std::move(_r));
+            } else {
+                const auto& res = std::tie(args...);
+                const auto& may_be_ec = __unwrap_first(res);
+                if constexpr(requires { may_be_ec == std::errc::operation_canceled; }){
+                    if(may_be_ec == std::errc::operation_canceled){
+                        __stop();
+                        return;
+                    }
+                }
+                __ex::set_value(std::move(_r), std::move(args)...);
+            }
+        }
+    };
+
+    template<__ex::receiver R>
+    struct __operation final: __operation_base<R> {
+        using operation_state_concept = __ex::operation_state_tag;
+
+        __operation(initializer_type&& i, R&& r)
+            : __operation_base<R>(std::move(i), std::move(r))
+        {}
+
+        enum struct __state_t: char{
+            construction, emplaced, initiated, stopped
+        };
+
+        __io::cancellation_signal _signal{};
+        std::atomic<__state_t> _state{__state_t::construction};
+
+        struct __stop_t{
+            __operation *self;
+            void operator()()noexcept{
+                __state_t expected = self->_state.load(std::memory_order_relaxed);
+                while(!self->_state.compare_exchange_weak(expected, __state_t::stopped, std::memory_order_acq_rel))
+                {}
+                __with_metrics(self->_metrics, [](context_metrics& m){ m.__on_stop_request(); });
+                __trace(self, self->__trace_name, __trace_phase::stop_requested);
+                if(expected == __state_t::initiated){
+                    self->_signal.emit(__io::cancellation_type_t::total);
+                }
+            }
+        };
+
+        using __stop_callback_t = typename __ex::stop_token_of_t<__ex::env_of_t<R>&>:: template callback_type<__stop_t>;
+        std::optional<__stop_callback_t> _stop_callback{};
+
+        void __init(){
+            this->__on_initiate();
+            auto initializer{std::move(this->__get_initializer())};
+            std::move(initializer)(use_sender_handler<Args...>{
+                {
+                    .op{this},
+                    .allocator{&this->__emplace_buffer()}
+                },
+                _signal.slot()
+            });
+        }
+
+        void complete(Args ...args)noexcept override{
+            _stop_callback.reset();
+            __operation_base<R>::complete(std::move(args)...);
+        }
+
+        void start() & noexcept
+        {
+            this->__on_start();
+            const auto st = __ex::get_stop_token(__ex::get_env(this->_r));
+            if(st.stop_requested()){
+                this->__stop();
+                return;
+            }
+            _stop_callback.emplace(st, __stop_t{this});
+            __state_t expected = __state_t::construction;
+            if(!_state.compare_exchange_strong(expected, __state_t::emplaced, std::memory_order_acq_rel)){
+                _stop_callback.reset();
+                this->__stop();
+                return;
+            }
+            //初始化IO
+            try{
+                this->__init();
+            }catch(...){
+                _stop_callback.reset();
+                this->__error();
+                return;
+            }
+            // 如果没有请求取消，self._state == __state_t::emplaced
+            expected = __state_t::emplaced;
+            if(!_state.compare_exchange_strong(expected, __state_t::initiated, std::memory_order_acq_rel)){
+                // 已经请求取消，但stop_callback不会发出取消信号（见__stop_t的if分支）
+                _stop_callback.reset();
+                _signal.emit(__io::cancellation_type_t::total);
+                return;
+            }
+        }
+    };
+
+    template<__ex::receiver R>
+    struct __asio_op_without_cancellation final: __operation_base<R> {
+        using operation_state_concept = __ex::operation_state_tag;
+
+        __asio_op_without_cancellation(initializer_type&& i, R&& r)
+            : __operation_base<R>(std::move(i), std::move(r))
+        {}
+
+        void start() & noexcept{
+            this->__on_start();
+            try {
+                this->__init();
+            }
+            catch (...) {
+                this->__error();
+            }
+        }
+    };
+
+    struct __transfer_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = __ex::completion_signatures<
+            __ex::set_value_t(Args...),
+            __ex::set_error_t(std::exception_ptr),
+            __ex::set_stopped_t()
+        >;
+
+        initializer_type _init;
+
+        template<__ex::receiver R>
+        struct __transfer_op_without_cancellation final: __operation_base<R> {
+            using operation_state_concept = __ex::operation_state_tag;
+
+            __transfer_op_without_cancellation(initializer_type&& i, R&& r)
+                : __operation_base<R>(std::move(i), std::move(r))
+            {}
+
+            void start() & noexcept
+            {
+                this->__on_start();
+                try {
+                    this->__init();
+                }
+                catch (...) {
+                    this->__error();
+                }
+            }
+        };
+
+        template<__ex::receiver R>
+        __ex::operation_state auto connect(R&& r) && {
+            if constexpr(__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
+                return __transfer_op_without_cancellation<std::decay_t<R>>(
+                    std::move(this->_init),
+                    std::forward<R>(r)
+                );
+            }else{
+                return __operation<std::decay_t<R>>(
+                    std::move(this->_init),
+                    std::forward<R>(r)
+                );
+            }
+        }
+    };
+
+    template<__ex::receiver R>
+    __ex::operation_state auto connect(R&& r) &&
+    {
+        const auto& env = __ex::get_env(r);
+        if constexpr(requires { __ex::get_scheduler(env); }){
+            return __ex::connect(
+                __ex::continues_on(__transfer_sender{._init{std::move(this->_init)}}, __ex::get_scheduler(env)),
+                std::forward<R>(r)
+            );
+        }else{
+            if constexpr(__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
+                return __asio_op_without_cancellation<std::decay_t<R>>(
+                    std::move(this->_init),
+                    std::forward<R>(r)
+                );
+            }else{
+                return __operation<std::decay_t<R>>(
+                    std::move(this->_init),
+                    std::forward<R>(r)
+                );
+            }
+        }
+    }
+
+    // 所有完成都会回到接收者环境中的调度器，exec::task无需再包一层continues_on
+    static constexpr bool __is_scheduler_affine = true;
+
+    template<class Promise>
+    struct __awaiter {
+        using __value_t = typename __await_value<Args...>::type;
+
+        struct __receiver_t {
+            using receiver_concept = __ex::receiver_t;
+
+            __awaiter* self;
+
+            template<class ...Ts>
+            void set_value(Ts&& ...vs)&& noexcept {
+                try{
+                    self->_value.emplace(std::forward<Ts>(vs)...);
+                }catch(...){
+                    self->_error = std::current_exception();
+                }
+                self->_continuation.resume();
+            }
+
+            template<class E>
+            void set_error(E&& e)&& noexcept {
+                if constexpr(std::is_same_v<std::decay_t<E>, std::exception_ptr>)
+                    self->_error = std::forward<E>(e);
+                else
+                    self->_error = std::make_exception_ptr(std::forward<E>(e));
+                self->_continuation.resume();
+            }
+
+            void set_stopped()&& noexcept {
+                self->_continuation.promise().unhandled_stopped().resume();
+            }
+
+            __ex::env_of_t<Promise&> get_env()const noexcept {
+                return __ex::get_env(self->_continuation.promise());
+            }
+        };
+
+        using __direct_op_t = decltype(std::declval<__transfer_sender>().connect(std::declval<__receiver_t>()));
+        using __fallback_op_t = __ex::connect_result_t<__sender, __receiver_t>;
+
+        enum struct __which_t: char {
+            none, direct, fallback
+        };
+
+        union __storage_t {
+            __storage_t()noexcept {}
+            ~__storage_t() {}
+            __direct_op_t direct;
+            __fallback_op_t fallback;
+        };
+
+        __sender _sndr;
+        std::coroutine_handle<Promise> _continuation{};
+        std::optional<__value_t> _value{};
+        std::exception_ptr _error{};
+        __which_t _which = __which_t::none;
+        __storage_t _storage;
+
+        explicit __awaiter(__sender&& s)noexcept:
+            _sndr{std::move(s)}
+        {}
+
+        // 只允许在co_await之前移动
+        __awaiter(__awaiter&& other)noexcept:
+            _sndr{std::move(other._sndr)}
+        {
+            assert(other._which == __which_t::none);
+        }
+
+        ~__awaiter() {
+            if(_which == __which_t::direct)
+                _storage.direct.~__direct_op_t();
+            else if(_which == __which_t::fallback)
+                _storage.fallback.~__fallback_op_t();
+        }
+
+        // 协程已运行在IO对象的执行器上时，asio完成回调可以直接恢复协程
+        bool __can_resume_inline()const noexcept {
+            if constexpr(requires (const initializer_type& i) { i.get_executor(); }){
+                const auto& env = __ex::get_env(_continuation.promise());
+                if constexpr(requires { __ex::get_scheduler(env); }){
+                    auto sched = __ex::get_scheduler(env);
+                    if constexpr(requires { sched.get_executor(); })
+                        return __same_executor(sched.get_executor(), _sndr._init.get_executor());
+                    else
+                        return __running_in_this_thread(_sndr._init.get_executor());
+                }
+            }
+            return false;
+        }
+
+        bool await_ready()const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<Promise> h) {
+            _continuation = h;
+            if(__can_resume_inline()){
+                ::new(static_cast<void*>(std::addressof(_storage.direct))) __direct_op_t(
+                    __transfer_sender{._init{std::move(_sndr._init)}}.connect(__receiver_t{this})
+                );
+                _which = __which_t::direct;
+                __ex::start(_storage.direct);
+            }else{
+                ::new(static_cast<void*>(std::addressof(_storage.fallback))) __fallback_op_t(
+                    std::move(_sndr).connect(__receiver_t{this})
+                );
+                _which = __which_t::fallback;
+                __ex::start(_storage.fallback);
+            }
+        }
+
+        auto await_resume() {
+            if(_error)
+                std::rethrow_exception(_error);
+            if constexpr(sizeof...(Args) != 0)
+                return std::move(*_value);
+        }
+    };
+
+    template<class Promise>
+    __awaiter<Promise> as_awaitable(Promise&) && {
+        return __awaiter<Promise>{std::move(*this)};
+    }
+
+}; // __sender
+
+}// __detail
+
+template<class ...Args>
+using sender = __detail::__sender<__detail::__any_initializer<Args...>, Args...>;
+
+template <class Executor>
+using basic_scheduler = __detail::basic_scheduler<Executor>;
+
+using scheduler = __detail::basic_scheduler<>;
+
+static_assert(__ex::scheduler<scheduler>);
+
+namespace __detail{
+
+struct __strand_node {
+    std::atomic<__strand_node*> _next{nullptr};
+    void (*_execute)(__strand_node*) noexcept = nullptr;
+};
+
+// 内联执行的嵌套深度，超过上限后改为post，避免栈无限增长
+inline thread_local std::size_t __strand_depth = 0;
+
+template<class Executor>
+struct __strand_state: std::enable_shared_from_this<__strand_state<Executor>> {
+    static constexpr std::size_t __max_depth = 16;
+    static constexpr std::size_t __batch = 64;
+
+    Executor _executor;
+    // 尚未执行完的节点数，从0变为1的一方获得执行权
+    std::atomic<std::size_t> _pending{0};
+    // 无锁MPSC侵入式队列(Vyukov)，只有持有执行权的一方出队
+    std::atomic<__strand_node*> _head;
+    __strand_node* _tail;
+    __strand_node _stub{};
+    // 持有执行权的一方post失败后把执行权留在这里，由下一次__submit接手
+    std::atomic<bool> _parked{false};
+
+    explicit __strand_state(Executor ex):
+        _executor{std::move(ex)},
+        _head{&_stub},
+        _tail{&_stub}
+    {}
+
+    void __push(__strand_node* n)noexcept {
+        n->_next.store(nullptr, std::memory_order_relaxed);
+        __strand_node* prev = _head.exchange(n, std::memory_order_acq_rel);
+        prev->_next.store(n, std::memory_order_release);
+    }
+
+    __strand_node* __try_pop()noexcept {
+        __strand_node* tail = _tail;
+        __strand_node* next = tail->_next.load(std::memory_order_acquire);
+        if(tail == &_stub){
+            if(!next)
+                return nullptr;
+            _tail = tail = next;
+            next = next->_next.load(std::memory_order_acquire);
+        }
+        if(next){
+            _tail = next;
+            return tail;
+        }
+        if(tail != _head.load(std::memory_order_acquire))
+            return nullptr;
+        __push(&_stub);
+        next = tail->_next.load(std::memory_order_acquire);
+        if(next){
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // _pending保证队列中有节点，生产者可能还没来得及链接，短暂自旋
+    __strand_node* __pop()noexcept {
+        for(;;){
+            if(__strand_node* n = __try_pop())
+                return n;
+            std::this_thread::yield();
+        }
+    }
+
+    // 持有执行权时调用；first为空表示从队列取
+    void __drain(__strand_node* first)noexcept {
+        __strand_node* n = first ? first : __pop();
+        for(std::size_t budget = __batch;;){
+            n->_execute(n);
+            if(_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                return;
+            if(--budget == 0){
+                // 让出线程，执行权随post一起转移；post失败时不让出，继续在本线程上执行
+                try{
+                    __post_drain(nullptr);
+                    return;
+                }catch(...){
+                    budget = __batch;
+                }
+            }
+            n = __pop();
+        }
+    }
+
+    void __post_drain(__strand_node* first) {
+        __io::post(_executor, [self = this->shared_from_this(), first]{
+            self->__drain(first);
+        });
+    }
+
+    // 持有执行权且队列非空时调用：post一个排空处理器，失败时交给下一次__submit
+    void __hand_off()noexcept {
+        try{
+            __post_drain(nullptr);
+        }catch(...){
+            _parked.store(true, std::memory_order_release);
+        }
+    }
+
+    // 抛出异常时n没有入队，由调用方完成它
+    void __submit(__strand_node* n) {
+        if(_pending.fetch_add(1, std::memory_order_acq_rel) != 0){
+            __push(n);
+            if(_parked.exchange(false, std::memory_order_acq_rel))
+                __hand_off();
+            return;
+        }
+        // strand空闲：已在上下文线程上时直接执行
+        if(__strand_depth < __max_depth && __running_in_this_thread(_executor)){
+            ++__strand_depth;
+            __drain(n);
+            --__strand_depth;
+            return;
+        }
+        try{
+            __post_drain(n);
+        }catch(...){
+            // 撤回n的计数；期间排队的节点属于其它调用方，不在本线程上执行它们
+            if(_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                __hand_off();
+            throw;
+        }
+    }
+};
+
+} // namespace __detail
+
+// 串行化执行的调度器：空闲且调用者已在上下文线程上时内联执行，否则经无锁队列排队
+template<class Executor = __io::io_context::executor_type>
+class basic_strand_scheduler {
+public:
+    using executor_type = Executor;
+    using scheduler_concept = __ex::scheduler_tag;
+
+    explicit basic_strand_scheduler(executor_type ex):
+        _state{std::make_shared<__detail::__strand_state<Executor>>(std::move(ex))}
+    {}
+
+    template <class ExecutionContext>
+        requires std::is_convertible_v<ExecutionContext&, __io::execution_context&>
+    explicit basic_strand_scheduler(ExecutionContext& ctx):
+        basic_strand_scheduler(executor_type{ctx.get_executor()})
+    {}
+
+    bool operator==(const basic_strand_scheduler&)const noexcept = default;
+
+    auto schedule() const noexcept {
+        return __schedule_sender_t{ _state };
+    }
+
+    executor_type get_executor() const noexcept {
+        return _state->_executor;
+    }
+
+private:
+    using __state_t = __detail::__strand_state<Executor>;
+
+    struct __schedule_sender_t {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = __ex::completion_signatures<
+            __ex::set_value_t(),
+            __ex::set_error_t(std::exception_ptr),
+            __ex::set_stopped_t()
+        >;
+
+        std::shared_ptr<__state_t> _state;
+
+        struct __env_t {
+            std::shared_ptr<__state_t> state;
+            template<class CPO>
+            auto query(__ex::get_completion_scheduler_t<CPO>) const noexcept {
+                return basic_strand_scheduler{ state };
+            }
+        };
+
+        template<__ex::receiver R>
+        struct __op: __detail::__strand_node {
+            using operation_state_concept = __ex::operation_state_tag;
+
+            std::shared_ptr<__state_t> _state;
+            R _r;
+
+            template<__ex::receiver _R>
+            __op(std::shared_ptr<__state_t> state, _R&& r)noexcept:
+                _state{ std::move(state) },
+                _r{ std::forward<_R>(r) }
+            {
+                this->_execute = [](__detail::__strand_node* n)noexcept {
+                    auto* self = static_cast<__op*>(n);
+                    __detail::__trace(self, "strand", __detail::__trace_phase::complete);
+                    __ex::set_value(std::move(self->_r));
+                };
+            }
+
+            __op(const __op&) = delete;
+            __op(__op&&) = delete;
+            __op& operator=(const __op&) = delete;
+            __op& operator=(__op&&) = delete;
+
+            void start() & noexcept{
+                __detail::__trace(this, "strand", __detail::__trace_phase::start);
+                if constexpr(!__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
+                    if(__ex::get_stop_token(__ex::get_env(_r)).stop_requested()){
+                        __detail::__trace(this, "strand", __detail::__trace_phase::stopped);
+                        __ex::set_stopped(std::move(_r));
+                        return;
+                    }
+                }
+                // 执行时可能销毁本操作，_state需要另外持有
+                std::shared_ptr<__state_t> state = _state;
+                try{
+                    state->__submit(this);
+                }catch(...){
+                    __ex::set_error(std::move(_r), std::current_exception());
+                }
+            }
+        };
+
+        template<__ex::receiver R>
+        auto connect(R&& r) && {
+            return __op<std::decay_t<R>>{ std::move(_state), std::forward<R>(r) };
+        }
+
+        __env_t get_env() const noexcept {
+            return __env_t{ _state };
+        }
+    };
+
+    explicit basic_strand_scheduler(std::shared_ptr<__state_t> state)noexcept:
+        _state{std::move(state)}
+    {}
+
+    std::shared_ptr<__state_t> _state;
+};
+
+using strand_scheduler = basic_strand_scheduler<>;
+
+static_assert(__ex::scheduler<strand_scheduler>);
+
+// read_many_at的一段读取请求，完成后ec与bytes_transferred被写回
+struct file_range {
+    std::uint64_t offset{};
+    __io::mutable_buffer buffer{};
+    __error_code ec{};
+    std::size_t bytes_transferred{};
+};
+
+namespace __detail{
+
+// 完成后回到接收者环境中的调度器上；环境没有调度器时直接连接
+template<class CoreSender, class R>
+__ex::operation_state auto __connect_on_scheduler(CoreSender&& core, R&& r) {
+    const auto& env = __ex::get_env(r);
+    if constexpr(requires { __ex::get_scheduler(env); }){
+        return __ex::connect(
+            __ex::continues_on(std::forward<CoreSender>(core), __ex::get_scheduler(env)),
+            std::forward<R>(r)
+        );
+    }else{
+        return std::forward<CoreSender>(core).connect(std::forward<R>(r));
+    }
+}
+
+// 同时发起一组(error_code, size_t)完成的异步操作，全部完成后才完成接收者
+// 每个操作占用一个槽：取消信号与供其处理器分配的内联缓冲区，BufferSize按该操作的实际大小选取
+// 槽数组与内联缓冲区溢出时的分配都使用接收者环境提供的内存资源
+// Derived提供__count、__initiate_all、__on_item、__canceled与__set_value，可以提供__prepare
+template<class Derived, class R, std::size_t BufferSize>
+struct __fan_out_op {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __slot {
+        __fan_out_op* op{};
+        __io::cancellation_signal signal{};
+        __sbo_buffer<BufferSize> buffer{};
+    };
+
+    struct __slots_deleter {
+        std::pmr::memory_resource* resource{};
+        std::size_t count{};
+
+        void operator()(__slot* p)const noexcept {
+            std::destroy_n(p, count);
+            std::pmr::polymorphic_allocator<__slot>{resource}.deallocate(p, count);
+        }
+    };
+
+    struct __handler {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using cancellation_slot_type = __io::cancellation_slot;
+
+        __slot* slot;
+
+        allocator_type get_allocator()const noexcept { return allocator_type{&slot->buffer}; }
+        cancellation_slot_type get_cancellation_slot()const noexcept { return slot->signal.slot(); }
+
+        void operator()(__error_code ec, std::size_t n)noexcept {
+            auto* const op = slot->op;
+            op->__derived().__on_item(static_cast<std::size_t>(slot - op->_slots.get()), ec, n);
+            op->__arrive();
+        }
+    };
+
+    enum struct __state_t: char{
+        initiating, initiated, stopped
+    };
+
+    struct __stop_t {
+        __fan_out_op* self;
+        void operator()()noexcept {
+            if(self->_state.exchange(__state_t::stopped, std::memory_order_acq_rel) == __state_t::initiated)
+                self->__emit_all();
+        }
+    };
+
+    using __stop_callback_t = typename __ex::stop_token_of_t<__ex::env_of_t<R>&>::template callback_type<__stop_t>;
+
+    R _r;
+    std::unique_ptr<__slot[], __slots_deleter> _slots{};
+    std::size_t _issued{};
+    std::atomic<std::size_t> _remaining{};
+    std::atomic<__state_t> _state{__state_t::initiating};
+    std::exception_ptr _error{};
+    std::optional<__stop_callback_t> _stop_callback{};
+
+    explicit __fan_out_op(R&& r):
+        _r{std::move(r)}
+    {}
+
+    __fan_out_op(__fan_out_op&&) = delete;
+
+    Derived& __derived()noexcept {
+        return static_cast<Derived&>(*this);
+    }
+
+    void __prepare(std::size_t)noexcept {}
+
+    // 由__initiate_all按顺序为每个操作调用一次
+    template<class Initiate>
+    void __issue(Initiate&& initiate) {
+        std::forward<Initiate>(initiate)(__handler{&_slots[_issued]});
+        ++_issued;
+    }
+
+    void __emit_all()noexcept {
+        for(std::size_t i = 0; i < _issued; ++i)
+            _slots[i].signal.emit(__io::cancellation_type_t::total);
+    }
+
+    void __arrive()noexcept {
+        if(_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        _stop_callback.reset();
+        if(_error){
+            __ex::set_error(std::move(_r), std::move(_error));
+            return;
+        }
+        if(_state.load(std::memory_order_acquire) == __state_t::stopped && __derived().__canceled()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        __derived().__set_value();
+    }
+
+    void start() & noexcept {
+        const std::size_t n = __derived().__count();
+        if(n == 0){
+            __derived().__set_value();
+            return;
+        }
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        auto* const resource = __env_resource(__ex::get_env(_r));
+        try{
+            __derived().__prepare(n);
+            std::pmr::polymorphic_allocator<__slot> alloc{resource};
+            __slot* const p = alloc.allocate(n);
+            std::uninitialized_default_construct_n(p, n);
+            _slots = std::unique_ptr<__slot[], __slots_deleter>{p, __slots_deleter{resource, n}};
+        }catch(...){
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
+        }
+        for(std::size_t i = 0; i < n; ++i){
+            _slots[i].op = this;
+            _slots[i].buffer.__rebind(resource);
+        }
+        // 多出的1防止在全部发起之前完成
+        _remaining.store(n + 1, std::memory_order_relaxed);
+        _stop_callback.emplace(st, __stop_t{this});
+
+        try{
+            __derived().__initiate_all();
+        }catch(...){
+            _error = std::current_exception();
+            _remaining.fetch_sub(n - _issued, std::memory_order_acq_rel);
+        }
+
+        __state_t expected = __state_t::initiating;
+        if(!_state.compare_exchange_strong(expected, __state_t::initiated, std::memory_order_acq_rel))
+            __emit_all();
+        __arrive();
+    }
+};
+
+// 随机访问设备的读操作因后端(io_uring/IOCP)而异，保留较大的内联缓冲区
+template<class Device, class R>
+struct __read_many_op: __fan_out_op<__read_many_op<Device, R>, R, 256> {
+    Device* _device;
+    std::span<file_range> _ranges;
+
+    __read_many_op(Device* device, std::span<file_range> ranges, R&& r):
+        __read_many_op::__fan_out_op{std::move(r)}, _device{device}, _ranges{ranges}
+    {}
+
+    std::size_t __count()const noexcept {
+        return _ranges.size();
+    }
+
+    void __initiate_all() {
+        for(auto& fr: _ranges){
+            this->__issue([&](auto handler){
+                __io::async_read_at(*_device, fr.offset, fr.buffer, std::move(handler));
+            });
+        }
+    }
+
+    void __on_item(std::size_t i, __error_code ec, std::size_t n)noexcept {
+        _ranges[i].ec = ec;
+        _ranges[i].bytes_transferred = n;
+    }
+
+    bool __canceled()const noexcept {
+        return std::any_of(_ranges.begin(), _ranges.end(), [](const file_range& fr){
+            return fr.ec == std::errc::operation_canceled;
+        });
+    }
+
+    void __set_value()noexcept {
+        __ex::set_value(std::move(this->_r), _ranges);
+    }
+};
+
+template<class Device>
+struct __read_many_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(std::span<file_range>),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    Device* _device;
+    std::span<file_range> _ranges;
+
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __read_many_sender::completion_signatures;
+
+        Device* _device;
+        std::span<file_range> _ranges;
+
+        template<__ex::receiver R>
+        __read_many_op<Device, std::decay_t<R>> connect(R&& r) && {
+            return {_device, _ranges, std::forward<R>(r)};
+        }
+    };
+
+    template<__ex::receiver R>
+    __ex::operation_state auto connect(R&& r) && {
+        return __connect_on_scheduler(__core_sender{_device, _ranges}, std::forward<R>(r));
+    }
+};
+
+}// __detail
+
+// 对random_access_file等随机访问设备的定位读写，完成值为(error_code, size_t)
+template<class Device, class MutableBufferSequence>
+auto read_at(Device& device, std::uint64_t offset, const MutableBufferSequence& buffers) {
+    return __io::async_read_at(device, offset, buffers, use_sender);
+}
+
+template<class Device, class ConstBufferSequence>
+auto write_at(Device& device, std::uint64_t offset, const ConstBufferSequence& buffers) {
+    return __io::async_write_at(device, offset, buffers, use_sender);
+}
+
+// 一次性发起所有定位读取，全部完成后以同一个span完成；每段的结果写回file_range
+template<class Device>
+__detail::__read_many_sender<Device> read_many_at(Device& device, std::span<file_range> ranges)noexcept {
+    return {&device, ranges};
+}
+
+#if defined(__linux__)
+namespace __detail{
+
+// 在文件与socket之间中转splice的管道，随组合操作一起移动
+struct __splice_pipe {
+    int fds[2]{-1, -1};
+    std::size_t buffered{};
+
+    __splice_pipe() = default;
+    __splice_pipe(__splice_pipe&& other)noexcept:
+        fds{std::exchange(other.fds[0], -1), std::exchange(other.fds[1], -1)},
+        buffered{std::exchange(other.buffered, 0)}
+    {}
+    __splice_pipe& operator=(__splice_pipe&&) = delete;
+
+    ~__splice_pipe() {
+        if(fds[0] != -1)
+            ::close(fds[0]);
+        if(fds[1] != -1)
+            ::close(fds[1]);
+    }
+
+    bool __open()noexcept {
+        return fds[0] != -1 || ::pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0;
+    }
+};
+
+template<class Socket>
+struct __send_file_op {
+    static constexpr std::size_t __chunk = 1u << 20;
+
+    Socket* _socket;
+    int _fd;
+    off_t _offset;
+    std::size_t _remaining;
+    std::size_t _sent{};
+    bool _started{false};
+    bool _use_splice{false};
+    __splice_pipe _pipe{};
+
+    template<class Self>
+    void operator()(Self& self, __error_code ec = {}) {
+        if(!_started){
+            _started = true;
+            // __sender以total类型发出取消，async_compose默认只放行terminal
+            self.reset_cancellation_state(__io::enable_total_cancellation());
+            _socket->native_non_blocking(true, ec);
+        }else if(self.cancelled() != __io::cancellation_type::none){
+            self.complete(__io::error::operation_aborted, _sent);
+            return;
+        }
+        if(ec){
+            self.complete(ec, _sent);
+            return;
+        }
+        while(_remaining > 0 || _pipe.buffered > 0){
+            const int err = _use_splice ? __splice_some() : __sendfile_some();
+            if(err == 0)
+                continue;
+            if(err == EAGAIN || err == EWOULDBLOCK){
+                _socket->async_wait(__io::socket_base::wait_write, std::move(self));
+                return;
+            }
+            // 文件系统不支持sendfile时改用splice
+            if(!_use_splice && (err == EINVAL || err == ENOSYS) && _sent == 0 && _pipe.__open()){
+                _use_splice = true;
+                continue;
+            }
+            if(err == -1)
+                self.complete(__io::error::eof, _sent);
+            else
+                self.complete(__error_code{err, __io::error::get_system_category()}, _sent);
+            return;
+        }
+        self.complete(__error_code{}, _sent);
+    }
+
+    // 返回0表示有进展，-1表示文件提前结束，否则为errno
+    int __sendfile_some()noexcept {
+        const ssize_t n = ::sendfile(_socket->native_handle(), _fd, &_offset, std::min(_remaining, __chunk));
+        if(n > 0){
+            _sent += static_cast<std::size_t>(n);
+            _remaining -= static_cast<std::size_t>(n);
+            return 0;
+        }
+        if(n == 0)
+            return -1;
+        return errno == EINTR ? 0 : errno;
+    }
+
+    int __splice_some()noexcept {
+        if(_pipe.buffered == 0){
+            const ssize_t n = ::splice(_fd, &_offset, _pipe.fds[1], nullptr, std::min(_remaining, __chunk),
+                                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if(n == 0)
+                return -1;
+            if(n < 0)
+                return errno == EINTR ? 0 : errno;
+            _pipe.buffered = static_cast<std::size_t>(n);
+            _remaining -= static_cast<std::size_t>(n);
+        }
+        const ssize_t n = ::splice(_pipe.fds[0], nullptr, _socket->native_handle(), nullptr, _pipe.buffered,
+                                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if(n < 0)
+            return errno == EINTR ? 0 : errno;
+        _sent += static_cast<std::size_t>(n);
+        _pipe.buffered -= static_cast<std::size_t>(n);
+        return 0;
+    }
+};
+
+}// __detail
+
+// 零拷贝地把文件[offset, offset + len)写入socket；部分写入在同一个操作内续传
+// 完成签名为void(error_code, std::size_t)，文件提前结束时以error::eof完成
+template<class Socket, class CompletionToken = use_sender_t>
+auto send_file(Socket& socket, int fd, std::uint64_t offset, std::size_t len, CompletionToken&& token = CompletionToken{}) {
+    return __io::async_compose<CompletionToken, void(__error_code, std::size_t)>(
+        __detail::__send_file_op<Socket>{ &socket, fd, static_cast<off_t>(offset), len },
+        token,
+        socket
+    );
+}
+#endif
+
+// 把多个发送者提交的小帧合并成一次分散/聚集写
+// 每个write(frame)返回的sender在该帧被写出后以(error_code, std::size_t)完成
+template<class Socket>
+class coalescing_writer {
+public:
+    explicit coalescing_writer(
+        Socket& socket,
+        std::size_t max_batch_bytes = 64 * 1024,
+        std::chrono::nanoseconds linger = std::chrono::nanoseconds::zero()
+    ):
+        _socket{socket},
+        _timer{socket.get_executor()},
+        _max_batch_bytes{std::max<std::size_t>(max_batch_bytes, 1)},
+        _linger{linger}
+    {}
+
+    coalescing_writer(const coalescing_writer&) = delete;
+    coalescing_writer(coalescing_writer&&) = delete;
+    coalescing_writer& operator=(const coalescing_writer&) = delete;
+    coalescing_writer& operator=(coalescing_writer&&) = delete;
+
+    // 已post但尚未执行的刷新与linger定时器在析构后不再访问*this
+    ~coalescing_writer() {
+        std::lock_guard lk{_liveness->mtx};
+        _liveness->writer = nullptr;
+    }
+
+    // frame指向的内存必须保持有效，直到返回的sender完成；
+    // 所有返回的sender完成之前不能析构coalescing_writer
+    auto write(__io::const_buffer frame)noexcept;
+
+private:
+    struct __frame_base {
+        __frame_base* _next = nullptr;
+        __frame_base* _prev = nullptr;
+        bool _queued = false;
+        __io::const_buffer _buffer{};
+        void (*_complete)(__frame_base*, __error_code, std::size_t) noexcept = nullptr;
+    };
+
+    struct __list {
+        __frame_base* head = nullptr;
+        __frame_base* tail = nullptr;
+
+        void push_back(__frame_base* f)noexcept {
+            f->_next = nullptr;
+            f->_prev = tail;
+            if(tail)
+                tail->_next = f;
+            else
+                head = f;
+            tail = f;
+        }
+
+        void unlink(__frame_base* f)noexcept {
+            if(f->_prev)
+                f->_prev->_next = f->_next;
+            else
+                head = f->_next;
+            if(f->_next)
+                f->_next->_prev = f->_prev;
+            else
+                tail = f->_prev;
+            f->_next = f->_prev = nullptr;
+        }
+    };
+
+    template<class R>
+    struct __frame_op;
+
+    struct __frame_sender;
+
+    struct __liveness_t {
+        explicit __liveness_t(coalescing_writer* w)noexcept:
+            writer{w}
+        {}
+
+        std::mutex mtx{};
+        coalescing_writer* writer;
+    };
+
+    // 在socket的执行器上以*this调用f，coalescing_writer已析构时什么也不做
+    template<class F>
+    void __post(F f) {
+        __io::post(_socket.get_executor(), [live = _liveness, f = std::move(f)]{
+            std::lock_guard lk{live->mtx};
+            if(live->writer)
+                f(*live->writer);
+        });
+    }
+
+    void __post_flush() {
+        __post([](coalescing_writer& w){ w.__flush(); });
+    }
+
+    // 仅在socket的执行器上调用
+    void __arm_linger() {
+        _timer.expires_after(_linger);
+        _timer.async_wait([live = _liveness](const __error_code& ec){
+            // 重新设定到期时间或析构都会中止上一次等待
+            if(ec == __io::error::operation_aborted)
+                return;
+            std::lock_guard lk{live->mtx};
+            if(live->writer)
+                live->writer->__flush();
+        });
+    }
+
+    // 任意线程：入队，必要时安排一次刷新
+    void __enqueue(__frame_base* f) {
+        bool post_flush = false;
+        bool arm_timer = false;
+        {
+            std::lock_guard lk{_mtx};
+            f->_queued = true;
+            _queue.push_back(f);
+            _queued_bytes += f->_buffer.size();
+            if(_writing)
+                return;
+            const bool full = _queued_bytes >= _max_batch_bytes;
+            if(!_flush_pending){
+                _flush_pending = true;
+                if(_linger.count() > 0 && !full){
+                    _lingering = true;
+                    arm_timer = true;
+                }else{
+                    post_flush = true;
+                }
+            }else if(_lingering && full){
+                // 攒够一批，不再等待linger
+                _lingering = false;
+                post_flush = true;
+            }
+        }
+        try{
+            if(arm_timer)
+                __post([](coalescing_writer& w){ w.__arm_linger(); });
+            else if(post_flush)
+                __post_flush();
+        }catch(...){
+            // 调用方随后撤回f；期间入队的其它帧依赖这次刷新，替它们再post一次
+            bool others;
+            {
+                std::lock_guard lk{_mtx};
+                others = _queue.head && (_queue.head != f || f->_next);
+                if(!others){
+                    _flush_pending = false;
+                    _lingering = false;
+                }
+            }
+            if(others){
+                try{
+                    __post_flush();
+                }catch(...){
+                    std::lock_guard lk{_mtx};
+                    _flush_pending = false;
+                    _lingering = false;
+                }
+            }
+            throw;
+        }
+    }
+
+    // 返回true表示帧仍在队列中并已被移除
+    bool __cancel(__frame_base* f)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!f->_queued)
+            return false;
+        _queue.unlink(f);
+        f->_queued = false;
+        _queued_bytes -= f->_buffer.size();
+        return true;
+    }
+
+    // 仅在socket的执行器上调用
+    void __flush() {
+        {
+            std::lock_guard lk{_mtx};
+            _flush_pending = false;
+            _lingering = false;
+            if(_writing || !_queue.head)
+                return;
+            _buffers.clear();
+            std::size_t bytes = 0;
+            while(_queue.head && (bytes == 0 || bytes + _queue.head->_buffer.size() <= _max_batch_bytes)){
+                __frame_base* f = _queue.head;
+                _queue.unlink(f);
+                f->_queued = false;
+                bytes += f->_buffer.size();
+                _buffers.push_back(f->_buffer);
+                _batch.push_back(f);
+            }
+            _queued_bytes -= bytes;
+            _writing = true;
+        }
+        __io::async_write(_socket, _buffers, [this](__error_code ec, std::size_t n){
+            __on_written(ec, n);
+        });
+    }
+
+    void __on_written(__error_code ec, std::size_t n) {
+        __list done = std::exchange(_batch, __list{});
+        {
+            std::lock_guard lk{_mtx};
+            _writing = false;
+        }
+        // 先发起下一批，再完成上一批的帧
+        __flush();
+        while(done.head){
+            __frame_base* f = done.head;
+            done.head = f->_next;
+            const std::size_t size = f->_buffer.size();
+            const std::size_t written = std::min(size, n);
+            n -= written;
+            f->_complete(f, written == size ? __error_code{} : ec, written);
+        }
+    }
+
+    Socket& _socket;
+    __io::steady_timer _timer;
+    const std::size_t _max_batch_bytes;
+    const std::chrono::nanoseconds _linger;
+    std::mutex _mtx{};
+    __list _queue{};
+    std::size_t _queued_bytes = 0;
+    bool _writing = false;
+    bool _flush_pending = false;
+    bool _lingering = false;
+    // 以下成员只在socket的执行器上访问
+    __list _batch{};
+    std::vector<__io::const_buffer> _buffers{};
+    const std::shared_ptr<__liveness_t> _liveness{std::make_shared<__liveness_t>(this)};
+};
+
+template<class Socket>
+template<class R>
+struct coalescing_writer<Socket>::__frame_op: coalescing_writer<Socket>::__frame_base {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __frame_op* self;
+        void operator()()noexcept {
+            if(self->_writer->__cancel(self))
+                __ex::set_stopped(std::move(self->_r));
+        }
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    coalescing_writer* _writer;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+
+    template<class _R>
+    __frame_op(coalescing_writer* writer, __io::const_buffer frame, _R&& r):
+        _writer{writer},
+        _r{std::forward<_R>(r)}
+    {
+        this->_buffer = frame;
+        this->_complete = [](__frame_base* f, __error_code ec, std::size_t n)noexcept {
+            auto* self = static_cast<__frame_op*>(f);
+            self->_stop_callback.reset();
+            __ex::set_value(std::move(self->_r), ec, n);
+        };
+    }
+
+    __frame_op(const __frame_op&) = delete;
+    __frame_op(__frame_op&&) = delete;
+    __frame_op& operator=(const __frame_op&) = delete;
+    __frame_op& operator=(__frame_op&&) = delete;
+
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        try{
+            _writer->__enqueue(this);
+        }catch(...){
+            if(_writer->__cancel(this)){
+                _stop_callback.reset();
+                __ex::set_error(std::move(_r), std::current_exception());
+            }
+        }
+    }
+};
+
+template<class Socket>
+struct coalescing_writer<Socket>::__frame_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(__error_code, std::size_t),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    coalescing_writer* _writer;
+    __io::const_buffer _frame;
+
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __frame_sender::completion_signatures;
+
+        coalescing_writer* _writer;
+        __io::const_buffer _frame;
+
+        template<__ex::receiver _R>
+        auto connect(_R&& r) && {
+            return __frame_op<std::decay_t<_R>>{ _writer, _frame, std::forward<_R>(r) };
+        }
+    };
+
+    template<__ex::receiver _R>
+    __ex::operation_state auto connect(_R&& r) && {
+        return __detail::__connect_on_scheduler(__core_sender{_writer, _frame}, std::forward<_R>(r));
+    }
+};
+
+template<class Socket>
+auto coalescing_writer<Socket>::write(__io::const_buffer frame)noexcept {
+    return __frame_sender{ this, frame };
+}
+
+// 引用计数的不可变缓冲区，多个写操作共享同一份数据
+class shared_buffer {
+public:
+    shared_buffer() = default;
+
+    // 复制data中的内容
+    explicit shared_buffer(__io::const_buffer data):
+        _size{data.size()}
+    {
+        auto p = std::make_shared_for_overwrite<char[]>(_size);
+        std::memcpy(p.get(), data.data(), _size);
+        _data = std::move(p);
+    }
+
+    shared_buffer(std::shared_ptr<const char[]> data, std::size_t size)noexcept:
+        _data{std::move(data)},
+        _size{size}
+    {}
+
+    const void* data()const noexcept { return _data.get(); }
+    std::size_t size()const noexcept { return _size; }
+    long use_count()const noexcept { return _data.use_count(); }
+
+    __io::const_buffer buffer()const noexcept {
+        return __io::const_buffer{_data.get(), _size};
+    }
+
+private:
+    std::shared_ptr<const char[]> _data{};
+    std::size_t _size = 0;
+};
+
+namespace __detail{
+
+// range的元素可以是socket本身，也可以是指向socket的指针
+template<class T>
+decltype(auto) __socket_ref(T& s)noexcept {
+    if constexpr(requires { s.get_executor(); })
+        return (s);
+    else
+        return (*s);
+}
+
+// 每个socket的内联缓冲区按async_write在reactor上的操作大小(约184字节)选取，
+// 其他后端的更大操作溢出到接收者环境提供的内存资源
+template<class Sockets, class R>
+struct __broadcast_op: __fan_out_op<__broadcast_op<Sockets, R>, R, 192> {
+    Sockets* _sockets;
+    shared_buffer _data;
+    std::pmr::vector<__error_code> _errors{__env_resource(__ex::get_env(this->_r))};
+
+    __broadcast_op(Sockets* sockets, shared_buffer data, R&& r):
+        __broadcast_op::__fan_out_op{std::move(r)}, _sockets{sockets}, _data{std::move(data)}
+    {}
+
+    std::size_t __count()const noexcept {
+        return std::ranges::size(*_sockets);
+    }
+
+    void __prepare(std::size_t n) {
+        _errors.resize(n);
+    }
+
+    void __initiate_all() {
+        for(auto&& s: *_sockets){
+            this->__issue([&](auto handler){
+                __io::async_write(__socket_ref(s), _data.buffer(), std::move(handler));
+            });
+        }
+    }
+
+    void __on_item(std::size_t i, __error_code ec, std::size_t)noexcept {
+        _errors[i] = ec;
+    }
+
+    bool __canceled()const noexcept {
+        return std::any_of(_errors.begin(), _errors.end(), [](const __error_code& ec){
+            return ec == std::errc::operation_canceled;
+        });
+    }
+
+    void __set_value()noexcept {
+        __ex::set_value(std::move(this->_r), std::move(_errors));
+    }
+};
+
+template<class Sockets>
+struct __broadcast_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(std::pmr::vector<__error_code>),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    Sockets* _sockets;
+    shared_buffer _data;
+
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __broadcast_sender::completion_signatures;
+
+        Sockets* _sockets;
+        shared_buffer _data;
+
+        template<__ex::receiver R>
+        __broadcast_op<Sockets, std::decay_t<R>> connect(R&& r) && {
+            return {_sockets, std::move(_data), std::forward<R>(r)};
+        }
+    };
+
+    template<__ex::receiver R>
+    __ex::operation_state auto connect(R&& r) && {
+        return __connect_on_scheduler(__core_sender{_sockets, std::move(_data)}, std::forward<R>(r));
+    }
+};
+
+}// __detail
+
+// 把同一份数据写到range中的每个socket，全部写完后以与range同序的error_code数组完成，
+// 该数组从接收者环境提供的内存资源分配
+// 单个socket出错不影响其他socket；sockets需保持有效直到sender完成
+template<std::ranges::sized_range Sockets>
+__detail::__broadcast_sender<Sockets> broadcast_write(Sockets& sockets, shared_buffer data)noexcept {
+    return {&sockets, std::move(data)};
+}
+
+// 在一条连接上复用多个请求：帧格式为4字节长度、4字节请求id(均为大端)和负载
+// 请求帧被追加到同一个发送缓冲区，由一个写操作批量写出；run()返回的读操作按id把响应分发给等待者
+// 服务端以相同的id返回响应，响应可以乱序
+template<class Socket>
+class multiplex_client {
+public:
+    static constexpr std::size_t header_size = 8;
+
+    explicit multiplex_client(Socket& socket):
+        _socket{socket}
+    {}
+
+    multiplex_client(const multiplex_client&) = delete;
+    multiplex_client(multiplex_client&&) = delete;
+    multiplex_client& operator=(const multiplex_client&) = delete;
+    multiplex_client& operator=(multiplex_client&&) = delete;
+
+    // 以(error_code, std::size_t)完成，响应负载写入response；
+    // response不够大时多余部分被丢弃并以message_size完成。request在sender完成前必须保持有效
+    auto request(__io::const_buffer request, __io::mutable_buffer response)noexcept;
+
+    // 持续读取并分发响应，直到连接出错或收到停止请求；以连接的error_code完成
+    // 未完成的请求在读操作结束时以同一个error_code完成
+    auto run()noexcept;
+
+    std::size_t in_flight()const {
+        std::lock_guard lk{_mtx};
+        return _in_flight.size();
+    }
+
+private:
+    struct __request_base {
+        std::uint32_t _id = 0;
+        __io::mutable_buffer _response{};
+        void (*_complete)(__request_base*, __error_code, std::size_t) noexcept = nullptr;
+    };
+
+    struct __run_base {
+        void (*_complete)(__run_base*, __error_code) noexcept = nullptr;
+    };
+
+    template<class R>
+    struct __request_op;
+
+    struct __request_sender;
+
+    template<class R>
+    struct __run_op;
+
+    struct __run_sender;
+
+    static void __put_u32(char* p, std::uint32_t v)noexcept {
+        p[0] = static_cast<char>(v >> 24);
+        p[1] = static_cast<char>(v >> 16);
+        p[2] = static_cast<char>(v >> 8);
+        p[3] = static_cast<char>(v);
+    }
+
+    static std::uint32_t __get_u32(const char* p)noexcept {
+        const auto* u = reinterpret_cast<const unsigned char*>(p);
+        return (std::uint32_t{u[0]} << 24) | (std::uint32_t{u[1]} << 16) | (std::uint32_t{u[2]} << 8) | std::uint32_t{u[3]};
+    }
+
+    // 任意线程：登记请求并把帧追加到发送缓冲区；返回false表示已请求停止
+    // 抛出异常时请求已被撤回，返回true后不能再访问req
+    template<class StopToken>
+    bool __submit(__request_base* req, __io::const_buffer frame, const StopToken& st) {
+        bool post_flush;
+        {
+            std::lock_guard lk{_mtx};
+            if(st.stop_requested())
+                return false;
+            if(_failed)
+                throw __system_error{_failed};
+            std::uint32_t id;
+            do{
+                id = _next_id++;
+            }while(_in_flight.contains(id));
+            req->_id = id;
+            const std::size_t offset = _pending.size();
+            _pending.resize(offset + header_size + frame.size());
+            try{
+                _in_flight.emplace(id, req);
+            }catch(...){
+                _pending.resize(offset);
+                throw;
+            }
+            __put_u32(_pending.data() + offset, static_cast<std::uint32_t>(frame.size()));
+            __put_u32(_pending.data() + offset + 4, id);
+            std::memcpy(_pending.data() + offset + header_size, frame.data(), frame.size());
+            post_flush = !std::exchange(_flush_scheduled, true);
+        }
+        if(post_flush){
+            try{
+                __io::post(_socket.get_executor(), [this]{ __flush(); });
+            }catch(...){
+                // 帧留在发送缓冲区中，由下一次刷新写出，其响应会被丢弃
+                bool removed;
+                {
+                    std::lock_guard lk{_mtx};
+                    _flush_scheduled = false;
+                    removed = __take(req);
+                }
+                // 未能移除说明停止回调已经以set_stopped完成了该请求
+                if(removed)
+                    throw;
+            }
+        }
+        return true;
+    }
+
+    // 返回true表示请求仍在等待响应并已被移除
+    bool __cancel(__request_base* req)noexcept {
+        std::lock_guard lk{_mtx};
+        return __take(req);
+    }
+
+    // 持有_mtx时调用
+    bool __take(__request_base* req)noexcept {
+        auto it = _in_flight.find(req->_id);
+        if(it == _in_flight.end() || it->second != req)
+            return false;
+        _in_flight.erase(it);
+        return true;
+    }
+
+    // 以下只在socket的执行器上调用
+    void __flush()noexcept {
+        {
+            std::lock_guard lk{_mtx};
+            if(_writing || _pending.empty()){
+                _flush_scheduled = false;
+                return;
+            }
+            _writing = true;
+            _flush_scheduled = false;
+            _outgoing.clear();
+            std::swap(_outgoing, _pending);
+        }
+        __io::async_write(_socket, __io::buffer(_outgoing), __handler<__on_written_t>{this, &_write_buffer});
+    }
+
+    struct __on_written_t {
+        void operator()(multiplex_client* self, __error_code ec, std::size_t)noexcept {
+            {
+                std::lock_guard lk{self->_mtx};
+                self->_writing = false;
+            }
+            if(ec)
+                self->__fail(ec);
+            else
+                self->__flush();
+        }
+    };
+
+    struct __on_header_t {
+        void operator()(multiplex_client* self, __error_code ec, std::size_t)noexcept {
+            if(ec){
+                self->__finish_run(ec);
+                return;
+            }
+            const std::uint32_t len = __get_u32(self->_header.data());
+            const std::uint32_t id = __get_u32(self->_header.data() + 4);
+            {
+                std::lock_guard lk{self->_mtx};
+                auto it = self->_in_flight.find(id);
+                if(it != self->_in_flight.end()){
+                    self->_reading = it->second;
+                    self->_in_flight.erase(it);
+                }
+            }
+            self->_remaining = len;
+            self->_received = 0;
+            self->__read_payload();
+        }
+    };
+
+    struct __on_payload_t {
+        void operator()(multiplex_client* self, __error_code ec, std::size_t n)noexcept {
+            self->_remaining -= n;
+            if(self->_reading)
+                self->_received += n;
+            if(ec){
+                self->__finish_run(ec);
+                return;
+            }
+            self->__read_payload();
+        }
+    };
+
+    // 同一时刻只有一个读和一个写，处理器的内存来自各自固定的缓冲区
+    template<class F>
+    struct __handler {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using cancellation_slot_type = __io::cancellation_slot;
+
+        multiplex_client* self;
+        __detail::__sbo_buffer<256>* buffer;
+        __io::cancellation_signal* signal = nullptr;
+
+        allocator_type get_allocator()const noexcept { return allocator_type{buffer}; }
+        cancellation_slot_type get_cancellation_slot()const noexcept {
+            return signal ? signal->slot() : cancellation_slot_type{};
+        }
+
+        void operator()(__error_code ec, std::size_t n)noexcept {
+            F{}(self, ec, n);
+        }
+    };
+
+    void __read_header()noexcept {
+        __io::async_read(_socket, __io::buffer(_header), __handler<__on_header_t>{this, &_read_buffer, &_read_signal});
+    }
+
+    void __read_payload()noexcept {
+        __request_base* req = _reading;
+        if(_remaining == 0){
+            _reading = nullptr;
+            if(req)
+                req->_complete(req, {}, _received);
+            __read_header();
+            return;
+        }
+        // 超出response的部分读入_discard后丢弃
+        if(req && _received < req->_response.size()){
+            const std::size_t n = std::min(_remaining, req->_response.size() - _received);
+            __io::async_read(_socket, __io::buffer(static_cast<char*>(req->_response.data()) + _received, n),
+                __handler<__on_payload_t>{this, &_read_buffer, &_read_signal});
+            return;
+        }
+        if(req){
+            _reading = nullptr;
+            req->_complete(req, __io::error::message_size, _received);
+        }
+        const std::size_t n = std::min(_remaining, _discard.size());
+        __io::async_read(_socket, __io::buffer(_discard.data(), n), __handler<__on_payload_t>{this, &_read_buffer, &_read_signal});
+    }
+
+    void __start_run(__run_base* run)noexcept {
+        _run = run;
+        __read_header();
+    }
+
+    void __finish_run(__error_code ec)noexcept {
+        if(auto* req = std::exchange(_reading, nullptr))
+            req->_complete(req, ec, _received);
+        __fail(ec);
+        if(auto* run = std::exchange(_run, nullptr))
+            run->_complete(run, ec);
+    }
+
+    // 连接不可用：此后提交的请求以异常完成，未完成的请求以ec完成
+    void __fail(__error_code ec)noexcept {
+        std::unordered_map<std::uint32_t, __request_base*> failed;
+        {
+            std::lock_guard lk{_mtx};
+            if(!_failed)
+                _failed = ec;
+            failed.swap(_in_flight);
+            _pending.clear();
+        }
+        for(auto& [id, req]: failed)
+            req->_complete(req, ec, 0);
+    }
+
+    Socket& _socket;
+    mutable std::mutex _mtx{};
+    std::unordered_map<std::uint32_t, __request_base*> _in_flight{};
+    std::vector<char> _pending{};
+    std::uint32_t _next_id = 0;
+    bool _writing = false;
+    bool _flush_scheduled = false;
+    __error_code _failed{};
+    // 以下成员只在socket的执行器上访问
+    std::vector<char> _outgoing{};
+    __detail::__sbo_buffer<256> _write_buffer{};
+    __detail::__sbo_buffer<256> _read_buffer{};
+    __io::cancellation_signal _read_signal{};
+    std::array<char, header_size> _header{};
+    std::array<char, 4096> _discard{};
+    __request_base* _reading = nullptr;
+    std::size_t _remaining = 0;
+    std::size_t _received = 0;
+    __run_base* _run = nullptr;
+};
+
+template<class Socket>
+template<class R>
+struct multiplex_client<Socket>::__request_op: multiplex_client<Socket>::__request_base {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __request_op* self;
+        void operator()()noexcept {
+            if(self->_client->__cancel(self))
+                __ex::set_stopped(std::move(self->_r));
+        }
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    multiplex_client* _client;
+    __io::const_buffer _request;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+
+    template<class _R>
+    __request_op(multiplex_client* client, __io::const_buffer request, __io::mutable_buffer response, _R&& r):
+        _client{client},
+        _request{request},
+        _r{std::forward<_R>(r)}
+    {
+        this->_response = response;
+        this->_complete = [](__request_base* b, __error_code ec, std::size_t n)noexcept {
+            auto* self = static_cast<__request_op*>(b);
+            self->_stop_callback.reset();
+            __ex::set_value(std::move(self->_r), ec, n);
+        };
+    }
+
+    __request_op(const __request_op&) = delete;
+    __request_op(__request_op&&) = delete;
+    __request_op& operator=(const __request_op&) = delete;
+    __request_op& operator=(__request_op&&) = delete;
+
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        // 登记之后响应可能在其他线程上到达，此后不能再访问本操作
+        bool submitted;
+        try{
+            submitted = _client->__submit(this, _request, st);
+        }catch(...){
+            _stop_callback.reset();
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
+        }
+        if(!submitted){
+            _stop_callback.reset();
+            __ex::set_stopped(std::move(_r));
+        }
+    }
+};
+
+template<class Socket>
+struct multiplex_client<Socket>::__request_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(__error_code, std::size_t),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    multiplex_client* _client;
+    __io::const_buffer _request;
+    __io::mutable_buffer _response;
+
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __request_sender::completion_signatures;
+
+        multiplex_client* _client;
+        __io::const_buffer _request;
+        __io::mutable_buffer _response;
+
+        template<__ex::receiver _R>
+        auto connect(_R&& r) && {
+            return __request_op<std::decay_t<_R>>{ _client, _request, _response, std::forward<_R>(r) };
+        }
+    };
+
+    template<__ex::receiver _R>
+    __ex::operation_state auto connect(_R&& r) && {
+        return __detail::__connect_on_scheduler(__core_sender{_client, _request, _response}, std::forward<_R>(r));
+    }
+};
+
+template<class Socket>
+template<class R>
+struct multiplex_client<Socket>::__run_op: multiplex_client<Socket>::__run_base {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __run_op* self;
+        void operator()()noexcept {
+            __io::post(self->_client->_socket.get_executor(), [c = self->_client]{
+                c->_read_signal.emit(__io::cancellation_type_t::total);
+            });
+        }
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    multiplex_client* _client;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+
+    template<class _R>
+    __run_op(multiplex_client* client, _R&& r):
+        _client{client},
+        _r{std::forward<_R>(r)}
+    {
+        this->_complete = [](__run_base* b, __error_code ec)noexcept {
+            auto* self = static_cast<__run_op*>(b);
+            self->_stop_callback.reset();
+            const bool stopped = ec == __io::error::operation_aborted
+                && __ex::get_stop_token(__ex::get_env(self->_r)).stop_requested();
+            if(stopped)
+                __ex::set_stopped(std::move(self->_r));
+            else
+                __ex::set_value(std::move(self->_r), ec);
+        };
+    }
+
+    __run_op(const __run_op&) = delete;
+    __run_op(__run_op&&) = delete;
+    __run_op& operator=(const __run_op&) = delete;
+    __run_op& operator=(__run_op&&) = delete;
+
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        try{
+            if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+                _stop_callback.emplace(st, __on_stop{this});
+            // 读操作只在socket的执行器上运行
+            __io::dispatch(_client->_socket.get_executor(), [this]{ _client->__start_run(this); });
+        }catch(...){
+            _stop_callback.reset();
+            __ex::set_error(std::move(_r), std::current_exception());
+        }
+    }
+};
+
+template<class Socket>
+struct multiplex_client<Socket>::__run_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(__error_code),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    multiplex_client* _client;
+
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __run_sender::completion_signatures;
+
+        multiplex_client* _client;
+
+        template<__ex::receiver _R>
+        auto connect(_R&& r) && {
+            return __run_op<std::decay_t<_R>>{ _client, std::forward<_R>(r) };
+        }
+    };
+
+    template<__ex::receiver _R>
+    __ex::operation_state auto connect(_R&& r) && {
+        return __detail::__connect_on_scheduler(__core_sender{_client}, std::forward<_R>(r));
+    }
+};
+
+template<class Socket>
+auto multiplex_client<Socket>::request(__io::const_buffer request, __io::mutable_buffer response)noexcept {
+    return __request_sender{ this, request, response };
+}
+
+template<class Socket>
+auto multiplex_client<Socket>::run()noexcept {
+    return __run_sender{ this };
+}
+
+namespace __detail{
+
+template<class Socket>
+struct __accepted_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(Socket)
+    >;
+
+    Socket _socket;
+
+    template<class R>
+    struct __op {
+        using operation_state_concept = __ex::operation_state_tag;
+
+        Socket _socket;
+        R _r;
+
+        void start() & noexcept {
+            __ex::set_value(std::move(_r), std::move(_socket));
+        }
+    };
+
+    template<__ex::receiver R>
+    __op<std::decay_t<R>> connect(R&& r) && {
+        return { std::move(_socket), std::forward<R>(r) };
+    }
+};
+
+// 一个长期存在的操作：反复async_accept，把每个连接作为一项交给set_next
+// 循环只在acceptor的执行器上推进；多线程运行的io_context应让acceptor绑定strand
+template<class Acceptor, class R>
+struct __accept_stream_op {
+    using operation_state_concept = __ex::operation_state_tag;
+    using __socket_t = decltype(std::declval<Acceptor&>().accept());
+    using __item_t = __accepted_sender<__socket_t>;
+
+    struct __next_receiver {
+        using receiver_concept = __ex::receiver_t;
+
+        __accept_stream_op* self;
+
+        void set_value()&& noexcept {
+            self->__item_done(__item_result_t::value, {});
+        }
+
+        void set_stopped()&& noexcept {
+            self->__item_done(__item_result_t::stopped, {});
+        }
+
+        void set_error(std::exception_ptr e)&& noexcept {
+            self->__item_done(__item_result_t::error, std::move(e));
+        }
+
+        __ex::env_of_t<R> get_env()const noexcept {
+            return __ex::get_env(self->_r);
+        }
+    };
+
+    using __next_op_t = __ex::connect_result_t<exec::next_sender_of_t<R, __item_t>, __next_receiver>;
+
+    enum struct __item_result_t: char{
+        value, stopped, error
+    };
+
+    // 防止下一项在start()内同步完成时，在仍处于调用栈上的操作状态上重新emplace
+    enum struct __emit_phase_t: char{
+        idle, starting, completed_inline
+    };
+
+    enum struct __state_t: char{
+        idle, initiating, accepting, stopped
+    };
+
+    struct __stop_t {
+        __accept_stream_op* self;
+        void operator()()noexcept {
+            if(self->_state.exchange(__state_t::stopped, std::memory_order_acq_rel) == __state_t::accepting)
+                self->_signal.emit(__io::cancellation_type_t::total);
+        }
+    };
+
+    using __stop_callback_t = typename __ex::stop_token_of_t<__ex::env_of_t<R>&>::template callback_type<__stop_t>;
+
+    struct __handler {
+        using cancellation_slot_type = __io::cancellation_slot;
+
+        __accept_stream_op* self;
+
+        cancellation_slot_type get_cancellation_slot()const noexcept { return self->_signal.slot(); }
+
+        void operator()(__error_code ec, __socket_t sock) {
+            self->__on_accept(ec, std::move(sock));
+        }
+    };
+
+    struct __backoff_handler {
+        using cancellation_slot_type = __io::cancellation_slot;
+
+        __accept_stream_op* self;
+
+        cancellation_slot_type get_cancellation_slot()const noexcept { return self->_signal.slot(); }
+
+        void operator()(__error_code) {
+            self->__on_backoff();
+        }
+    };
+
+    static constexpr std::chrono::milliseconds __min_backoff{5};
+    static constexpr std::chrono::milliseconds __max_backoff{1000};
+
+    Acceptor* _acceptor;
+    const std::size_t _max_batch;
+    R _r;
+    __io::cancellation_signal _signal{};
+    std::atomic<__state_t> _state{__state_t::idle};
+    std::optional<__stop_callback_t> _stop_callback{};
+    std::vector<__socket_t> _pending{};
+    std::size_t _emitted = 0;
+    std::optional<__next_op_t> _next_op{};
+    std::atomic<__emit_phase_t> _emit_phase{__emit_phase_t::idle};
+    __item_result_t _item_result{};
+    std::exception_ptr _item_error{};
+    bool _restore_blocking = false;
+    std::optional<__io::steady_timer> _backoff_timer{};
+    std::chrono::milliseconds _backoff_delay{0};
+
+    __accept_stream_op(Acceptor* acceptor, std::size_t max_batch, R&& r):
+        _acceptor{acceptor},
+        _max_batch{std::max<std::size_t>(max_batch, 1)},
+        _r{std::move(r)}
+    {}
+
+    __accept_stream_op(__accept_stream_op&&) = delete;
+
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        try{
+            _pending.reserve(_max_batch);
+            if(_max_batch > 1 && !_acceptor->non_blocking()){
+                _acceptor->non_blocking(true);
+                _restore_blocking = true;
+            }
+            _stop_callback.emplace(st, __stop_t{this});
+            __io::dispatch(_acceptor->get_executor(), [this]{ __accept(); });
+        }catch(...){
+            __finish_error(std::current_exception());
+        }
+    }
+
+    // 发起一个绑定到_signal的异步等待，期间的停止请求通过_signal取消它
+    template<class Initiate>
+    void __initiate(Initiate&& initiate)noexcept {
+        __state_t expected = __state_t::idle;
+        if(!_state.compare_exchange_strong(expected, __state_t::initiating, std::memory_order_acq_rel)){
+            __finish_stopped();
+            return;
+        }
+        try{
+            initiate();
+        }catch(...){
+            __finish_error(std::current_exception());
+            return;
+        }
+        expected = __state_t::initiating;
+        if(!_state.compare_exchange_strong(expected, __state_t::accepting, std::memory_order_acq_rel))
+            _signal.emit(__io::cancellation_type_t::total);
+    }
+
+    void __accept()noexcept {
+        __initiate([this]{
+            _acceptor->async_accept(__handler{this});
+        });
+    }
+
+    // 单个连接的错误，例如对端在accept之前重置：跳过该连接继续接受
+    static bool __is_connection_error(const __error_code& ec)noexcept {
+        return ec == __io::error::connection_aborted
+            || ec == __io::error::connection_reset
+            || ec == std::errc::protocol_error
+            || ec == std::errc::operation_not_permitted
+            || ec == std::errc::network_down
+            || ec == std::errc::network_unreachable
+            || ec == std::errc::host_unreachable;
+    }
+
+    // 描述符或内存耗尽：保持监听，退避一段时间后重试
+    static bool __is_resource_error(const __error_code& ec)noexcept {
+        return ec == std::errc::too_many_files_open
+            || ec == std::errc::too_many_files_open_in_system
+            || ec == std::errc::no_buffer_space
+            || ec == std::errc::not_enough_memory;
+    }
+
+    // 退避时间从__min_backoff起倍增，至多__max_backoff，成功接受一个连接后复位
+    void __back_off()noexcept {
+        _backoff_delay = _backoff_delay.count() == 0 ? __min_backoff : std::min(_backoff_delay * 2, __max_backoff);
+        __initiate([this]{
+            if(!_backoff_timer)
+                _backoff_timer.emplace(_acceptor->get_executor());
+            _backoff_timer->expires_after(_backoff_delay);
+            _backoff_timer->async_wait(__backoff_handler{this});
+        });
+    }
+
+    void __on_backoff()noexcept {
+        __state_t expected = __state_t::accepting;
+        if(!_state.compare_exchange_strong(expected, __state_t::idle, std::memory_order_acq_rel)){
+            __finish_stopped();
+            return;
+        }
+        __accept();
+    }
+
+    void __on_accept(__error_code ec, __socket_t sock)noexcept {
+        __state_t expected = __state_t::accepting;
+        if(!_state.compare_exchange_strong(expected, __state_t::idle, std::memory_order_acq_rel)){
+            __finish_stopped();
+            return;
+        }
+        if(ec){
+            // acceptor被关闭视为序列结束
+            if(ec == std::errc::operation_canceled || ec == std::errc::bad_file_descriptor)
+                __finish_value();
+            else if(__is_connection_error(ec))
+                __accept();
+            else if(__is_resource_error(ec))
+                __back_off();
+            else
+                __finish_error(std::make_exception_ptr(__system_error{ec}));
+            return;
+        }
+        _backoff_delay = std::chrono::milliseconds{0};
+        try{
+            _pending.push_back(std::move(sock));
+            // 连接风暴时一次取走已就绪的连接，不再经过reactor
+            while(_pending.size() < _max_batch){
+                __error_code e;
+                auto more = _acceptor->accept(e);
+                if(e)
+                    break;
+                _pending.push_back(std::move(more));
+            }
+        }catch(...){
+            __finish_error(std::current_exception());
+            return;
+        }
+        _emitted = 0;
+        __emit();
+    }
+
+    // 在acceptor的执行器上运行；同步完成的项在这里循环处理，而不是递归调用
+    void __emit()noexcept {
+        for(;;){
+            if(_emitted == _pending.size()){
+                _pending.clear();
+                __accept();
+                return;
+            }
+            try{
+                _next_op.emplace(__conv{[this]{
+                    return __ex::connect(
+                        exec::set_next(_r, __item_t{ std::move(_pending[_emitted++]) }),
+                        __next_receiver{this}
+                    );
+                }});
+            }catch(...){
+                __finish_error(std::current_exception());
+                return;
+            }
+            _emit_phase.store(__emit_phase_t::starting, std::memory_order_relaxed);
+            __ex::start(*_next_op);
+            __emit_phase_t expected = __emit_phase_t::starting;
+            if(_emit_phase.compare_exchange_strong(expected, __emit_phase_t::idle, std::memory_order_acq_rel))
+                return;
+            // 已在start()内完成
+            _emit_phase.store(__emit_phase_t::idle, std::memory_order_relaxed);
+            if(_item_result != __item_result_t::value){
+                __after_item();
+                return;
+            }
+        }
+    }
+
+    void __item_done(__item_result_t result, std::exception_ptr e)noexcept {
+        _item_result = result;
+        _item_error = std::move(e);
+        __emit_phase_t expected = __emit_phase_t::starting;
+        if(_emit_phase.compare_exchange_strong(expected, __emit_phase_t::completed_inline, std::memory_order_acq_rel))
+            return;
+        if(result != __item_result_t::value || __running_in_this_thread(_acceptor->get_executor())){
+            __after_item();
+            return;
+        }
+        try{
+            __io::post(_acceptor->get_executor(), [this]{ __emit(); });
+        }catch(...){
+            __finish_error(std::current_exception());
+        }
+    }
+
+    void __after_item()noexcept {
+        switch(_item_result){
+        case __item_result_t::value:
+            __emit();
+            break;
+        case __item_result_t::stopped:
+            __finish_stopped();
+            break;
+        case __item_result_t::error:
+            __finish_error(std::move(_item_error));
+            break;
+        }
+    }
+
+    // 恢复start()之前acceptor的阻塞模式
+    void __release_acceptor()noexcept {
+        _stop_callback.reset();
+        if(std::exchange(_restore_blocking, false)){
+            __error_code ignored;
+            _acceptor->non_blocking(false, ignored);
+        }
+    }
+
+    void __finish_value()noexcept {
+        __release_acceptor();
+        __ex::set_value(std::move(_r));
+    }
+
+    void __finish_stopped()noexcept {
+        __release_acceptor();
+        __ex::set_stopped(std::move(_r));
+    }
+
+    void __finish_error(std::exception_ptr e)noexcept {
+        __release_acceptor();
+        __ex::set_error(std::move(_r), std::move(e));
+    }
+};
+
+template<class Acceptor>
+struct __accept_stream_sender {
+    using sender_concept = exec::sequence_sender_t;
+    using __socket_t = decltype(std::declval<Acceptor&>().accept());
+    using item_types = exec::item_types<__accepted_sender<__socket_t>>;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    Acceptor* _acceptor;
+    std::size_t _max_batch;
+
+    template<__ex::receiver R>
+    __accept_stream_op<Acceptor, std::decay_t<R>> subscribe(R&& r) && {
+        return { _acceptor, _max_batch, std::forward<R>(r) };
+    }
+};
+
+}// __detail
+
+// 以序列sender的形式持续接受连接，每个连接是一项set_value(socket)
+// max_batch > 1时，一次完成后会非阻塞地取走至多max_batch个已就绪连接；
+// 为此acceptor在序列运行期间被置为非阻塞模式，序列结束时恢复
+// 单个连接的错误(如connection_aborted)被跳过；描述符耗尽(EMFILE/ENFILE)时退避后重试，不结束序列
+template<class Acceptor>
+__detail::__accept_stream_sender<Acceptor> accept_stream(Acceptor& acceptor, std::size_t max_batch = 1)noexcept {
+    return { &acceptor, max_batch };
+}
+
+#if defined(__linux__)
+// 固定大小数据报缓冲区的池，receive_batch从中取缓冲区，datagram_batch析构时归还
+class datagram_pool {
+public:
+    datagram_pool(std::size_t datagram_size, std::size_t capacity):
+        _datagram_size{std::max<std::size_t>(datagram_size, 1)},
+        _storage(_datagram_size * capacity)
+    {
+        _free.reserve(capacity);
+        for(std::size_t i = capacity; i > 0; --i)
+            _free.push_back(static_cast<std::uint32_t>(i - 1));
+    }
+
+    datagram_pool(const datagram_pool&) = delete;
+    datagram_pool& operator=(const datagram_pool&) = delete;
+
+    std::size_t datagram_size()const noexcept { return _datagram_size; }
+
+    std::size_t available()const noexcept {
+        std::lock_guard lk{_mtx};
+        return _free.size();
+    }
+
+    // 以下供receive_batch与datagram_batch使用
+    std::size_t __acquire(std::size_t n, std::vector<__io::mutable_buffer>& out) {
+        std::lock_guard lk{_mtx};
+        n = std::min(n, _free.size());
+        for(std::size_t i = 0; i < n; ++i){
+            const std::uint32_t slot = _free.back();
+            _free.pop_back();
+            out.push_back(__io::buffer(_storage.data() + slot * _datagram_size, _datagram_size));
+        }
+        return n;
+    }
+
+    void __release(const void* p)noexcept {
+        const auto slot = static_cast<std::uint32_t>((static_cast<const unsigned char*>(p) - _storage.data()) / _datagram_size);
+        std::lock_guard lk{_mtx};
+        _free.push_back(slot);
+    }
+private:
+    const std::size_t _datagram_size;
+    std::vector<unsigned char> _storage;
+    mutable std::mutex _mtx{};
+    std::vector<std::uint32_t> _free{};
+};
+
+template<class Endpoint>
+struct basic_datagram {
+    Endpoint endpoint{};
+    __io::mutable_buffer data{};
+};
+
+// 一次receive_batch收到的数据报，析构时把缓冲区还给池
+template<class Endpoint>
+class basic_datagram_batch {
+public:
+    basic_datagram_batch() = default;
+
+    explicit basic_datagram_batch(datagram_pool* pool)noexcept:
+        _pool{pool}
+    {}
+
+    basic_datagram_batch(basic_datagram_batch&& other)noexcept:
+        _pool{std::exchange(other._pool, nullptr)},
+        _records{std::move(other._records)}
+    {}
+
+    basic_datagram_batch& operator=(basic_datagram_batch&& other)noexcept {
+        if(this != &other){
+            __release();
+            _pool = std::exchange(other._pool, nullptr);
+            _records = std::move(other._records);
+        }
+        return *this;
+    }
+
+    ~basic_datagram_batch() {
+        __release();
+    }
+
+    std::span<const basic_datagram<Endpoint>> records()const noexcept { return _records; }
+    auto begin()const noexcept { return _records.begin(); }
+    auto end()const noexcept { return _records.end(); }
+    std::size_t size()const noexcept { return _records.size(); }
+    bool empty()const noexcept { return _records.empty(); }
+    const basic_datagram<Endpoint>& operator[](std::size_t i)const noexcept { return _records[i]; }
+
+    std::vector<basic_datagram<Endpoint>>& __records()noexcept { return _records; }
+private:
+    void __release()noexcept {
+        if(_pool){
+            for(const auto& r: _records)
+                _pool->__release(r.data.data());
+        }
+        _records.clear();
+    }
+
+    datagram_pool* _pool = nullptr;
+    std::vector<basic_datagram<Endpoint>> _records{};
+};
+
+namespace __detail{
+
+template<class Socket>
+struct __receive_batch_op {
+    using __endpoint_t = typename Socket::endpoint_type;
+    using __batch_t = basic_datagram_batch<__endpoint_t>;
+
+    Socket* _socket;
+    datagram_pool* _pool;
+    std::size_t _max;
+    std::vector<__io::mutable_buffer> _buffers{};
+    std::vector<__endpoint_t> _endpoints{};
+    std::vector<::iovec> _iovs{};
+    std::vector<::mmsghdr> _msgs{};
+    bool _started = false;
+
+    template<class Self>
+    void operator()(Self& self, __error_code ec = {}) {
+        if(!std::exchange(_started, true)){
+            // __sender以total类型发出取消，async_compose默认只放行terminal
+            self.reset_cancellation_state(__io::enable_total_cancellation());
+        }else if(self.cancelled() != __io::cancellation_type::none){
+            self.complete(__io::error::operation_aborted, __batch_t{});
+            return;
+        }
+        if(ec){
+            self.complete(ec, __batch_t{});
+            return;
+        }
+        _buffers.clear();
+        const std::size_t n = _pool->__acquire(_max, _buffers);
+        if(n == 0){
+            self.complete(__io::error::no_buffer_space, __batch_t{});
+            return;
+        }
+        __batch_t batch{_pool};
+        _endpoints.resize(n);
+        _iovs.resize(n);
+        _msgs.resize(n);
+        for(std::size_t i = 0; i < n; ++i){
+            _iovs[i] = ::iovec{ _buffers[i].data(), _buffers[i].size() };
+            _msgs[i] = ::mmsghdr{};
+            _msgs[i].msg_hdr.msg_name = _endpoints[i].data();
+            _msgs[i].msg_hdr.msg_namelen = static_cast<::socklen_t>(_endpoints[i].capacity());
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int r;
+        do{
+            r = ::recvmmsg(_socket->native_handle(), _msgs.data(), static_cast<unsigned>(n), MSG_DONTWAIT, nullptr);
+        }while(r < 0 && errno == EINTR);
+        const int err = r < 0 ? errno : 0;
+        const std::size_t received = r < 0 ? 0 : static_cast<std::size_t>(r);
+
+        auto& records = batch.__records();
+        records.reserve(received);
+        for(std::size_t i = 0; i < received; ++i){
+            _endpoints[i].resize(_msgs[i].msg_hdr.msg_namelen);
+            records.push_back({ _endpoints[i], __io::buffer(_buffers[i].data(), _msgs[i].msg_len) });
+        }
+        for(std::size_t i = received; i < n; ++i)
+            _pool->__release(_buffers[i].data());
+
+        if(err == EAGAIN || err == EWOULDBLOCK){
+            _socket->async_wait(__io::socket_base::wait_read, std::move(self));
+            return;
+        }
+        if(err){
+            self.complete(__error_code{err, __io::error::get_system_category()}, __batch_t{});
+            return;
+        }
+        self.complete(__error_code{}, std::move(batch));
+    }
+};
+
+template<class Socket>
+struct __send_batch_op {
+    using __endpoint_t = typename Socket::endpoint_type;
+
+    Socket* _socket;
+    std::span<const basic_datagram<__endpoint_t>> _datagrams;
+    std::size_t _sent = 0;
+    std::vector<::iovec> _iovs{};
+    std::vector<::mmsghdr> _msgs{};
+    bool _started = false;
+
+    template<class Self>
+    void operator()(Self& self, __error_code ec = {}) {
+        if(!std::exchange(_started, true)){
+            self.reset_cancellation_state(__io::enable_total_cancellation());
+        }else if(self.cancelled() != __io::cancellation_type::none){
+            self.complete(__io::error::operation_aborted, _sent);
+            return;
+        }
+        if(ec){
+            self.complete(ec, _sent);
+            return;
+        }
+        while(_sent < _datagrams.size()){
+            const std::size_t n = std::min<std::size_t>(_datagrams.size() - _sent, 1024);
+            _iovs.resize(n);
+            _msgs.resize(n);
+            for(std::size_t i = 0; i < n; ++i){
+                auto& d = _datagrams[_sent + i];
+                _iovs[i] = ::iovec{ const_cast<void*>(d.data.data()), d.data.size() };
+                _msgs[i] = ::mmsghdr{};
+                _msgs[i].msg_hdr.msg_name = const_cast<void*>(static_cast<const void*>(d.endpoint.data()));
+                _msgs[i].msg_hdr.msg_namelen = static_cast<::socklen_t>(d.endpoint.size());
+                _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+                _msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int r = ::sendmmsg(_socket->native_handle(), _msgs.data(), static_cast<unsigned>(n), MSG_DONTWAIT);
+            if(r > 0){
+                _sent += static_cast<std::size_t>(r);
+                continue;
+            }
+            const int err = r < 0 ? errno : EAGAIN;
+            if(err == EINTR)
+                continue;
+            if(err == EAGAIN || err == EWOULDBLOCK){
+                _socket->async_wait(__io::socket_base::wait_write, std::move(self));
+                return;
+            }
+            self.complete(__error_code{err, __io::error::get_system_category()}, _sent);
+            return;
+        }
+        self.complete(__error_code{}, _sent);
+    }
+};
+
+}// __detail
+
+// 等待可读后用recvmmsg一次取走至多max_msgs个数据报
+// 完成签名为void(error_code, basic_datagram_batch<endpoint_type>)
+template<class Socket, class CompletionToken = use_sender_t>
+auto receive_batch(Socket& socket, datagram_pool& pool, std::size_t max_msgs, CompletionToken&& token = CompletionToken{}) {
+    return __io::async_compose<CompletionToken, void(__error_code, basic_datagram_batch<typename Socket::endpoint_type>)>(
+        __detail::__receive_batch_op<Socket>{ &socket, &pool, std::max<std::size_t>(max_msgs, 1) },
+        token,
+        socket
+    );
+}
+
+// 用sendmmsg发送全部数据报，完成签名为void(error_code, std::size_t)，后者为已发送的数据报个数
+template<class Socket, class CompletionToken = use_sender_t>
+auto send_batch(
+    Socket& socket,
+    std::span<const basic_datagram<typename Socket::endpoint_type>> datagrams,
+    CompletionToken&& token = CompletionToken{}
+) {
+    return __io::async_compose<CompletionToken, void(__error_code, std::size_t)>(
+        __detail::__send_batch_op<Socket>{ &socket, datagrams },
+        token,
+        socket
+    );
+}
+#endif
+
+// 有界无锁环形队列上的通道；队列非满/非空时send/receive在调用线程上直接完成
+// 等待者在自己环境中的调度器上被唤醒后重试，接收端每次唤醒可批量取走
+template<class T>
+class channel {
+public:
+    explicit channel(std::size_t capacity):
+        _mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1},
+        _cells{new __cell[_mask + 1]}
+    {
+        for(std::size_t i = 0; i <= _mask; ++i)
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    channel(const channel&) = delete;
+    channel(channel&&) = delete;
+    channel& operator=(const channel&) = delete;
+    channel& operator=(channel&&) = delete;
+
+    ~channel() {
+        while(__try_pop())
+            ;
+    }
+
+    // 通道关闭后以set_stopped完成
+    auto send(T value);
+
+    // 通道关闭且为空时以set_stopped完成
+    auto receive();
+
+    // 一次取走至多out.size()个元素，以取走的个数完成
+    auto receive_batch(std::span<T> out);
+
+    bool try_send(T& value) {
+        if(_closed.load(std::memory_order_acquire) || !__try_push(value))
+            return false;
+        __notify(_receivers, 1);
+        return true;
+    }
+
+    std::optional<T> try_receive() {
+        auto v = __try_pop();
+        if(v)
+            __notify(_senders, 1);
+        return v;
+    }
+
+    // 唤醒所有等待者，此后send以set_stopped完成，receive在取空后以set_stopped完成
+    void close()noexcept {
+        _closed.store(true, std::memory_order_seq_cst);
+        __notify(_senders, std::size_t(-1));
+        __notify(_receivers, std::size_t(-1));
+    }
+
+    bool closed()const noexcept {
+        return _closed.load(std::memory_order_acquire);
+    }
+
+private:
+    struct __cell {
+        std::atomic<std::size_t> seq;
+        // 构造T时抛出异常的槽仍按序发布，出队时跳过
+        bool poisoned = false;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct __waiter {
+        __waiter* _next = nullptr;
+        __waiter* _prev = nullptr;
+        bool _queued = false;
+        void (*_wake)(__waiter*) noexcept = nullptr;
+    };
+
+    struct __waiter_list {
+        __waiter* head = nullptr;
+        __waiter* tail = nullptr;
+        std::atomic<std::size_t> count{0};
+    };
+
+    enum struct __wait_result: char {
+        queued, ready, stopped
+    };
+
+    template<class Derived, class R>
+    struct __op_base;
+
+    template<class R>
+    struct __send_op;
+
+    template<class R>
+    struct __receive_op;
+
+    template<class R>
+    struct __receive_batch_op;
+
+    template<template<class> class Op, class ValueSig, class... Ts>
+    struct __sender;
+
+    bool __try_push(T& value) {
+        std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+        for(;;){
+            __cell& c = _cells[pos & _mask];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if(diff == 0){
+                if(_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        __cell& c = _cells[pos & _mask];
+        if constexpr(std::is_nothrow_move_constructible_v<T>){
+            ::new(static_cast<void*>(c.storage)) T(std::move(value));
+        }else{
+            try{
+                ::new(static_cast<void*>(c.storage)) T(std::move(value));
+            }catch(...){
+                c.poisoned = true;
+                c.seq.store(pos + 1, std::memory_order_release);
+                throw;
+            }
+        }
+        c.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> __try_pop() {
+        std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+        for(;;){
+            if(!__claim_pop(pos))
+                return std::nullopt;
+            __cell& c = _cells[pos & _mask];
+            if(c.poisoned){
+                c.poisoned = false;
+                c.seq.store(pos + _mask + 1, std::memory_order_release);
+                pos = _dequeue.load(std::memory_order_relaxed);
+                continue;
+            }
+            T* p = std::launder(reinterpret_cast<T*>(c.storage));
+            std::optional<T> v{std::move(*p)};
+            p->~T();
+            c.seq.store(pos + _mask + 1, std::memory_order_release);
+            return v;
+        }
+    }
+
+    // 成功时pos为取得的位置
+    bool __claim_pop(std::size_t& pos)noexcept {
+        for(;;){
+            __cell& c = _cells[pos & _mask];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if(diff == 0){
+                if(_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = _dequeue.load(std::memory_order_relaxed);
+            }
+        }
+        return true;
+    }
+
+    bool __empty()const noexcept {
+        return _dequeue.load(std::memory_order_acquire) >= _enqueue.load(std::memory_order_acquire);
+    }
+
+    bool __full()const noexcept {
+        return _enqueue.load(std::memory_order_acquire) - _dequeue.load(std::memory_order_acquire) > _mask;
+    }
+
+    // 停止检查、入队与再次检查在同一把锁内完成，与停止回调中的__remove_waiter互斥
+    // 返回queued后w可能已被唤醒方完成，调用方不能再访问它
+    template<class Ready, class StopToken>
+    __wait_result __enqueue_waiter(__waiter_list& list, __waiter* w, Ready&& ready, const StopToken& st)noexcept {
+        std::lock_guard lk{_mtx};
+        if(st.stop_requested())
+            return __wait_result::stopped;
+        w->_queued = true;
+        w->_next = nullptr;
+        w->_prev = list.tail;
+        if(list.tail)
+            list.tail->_next = w;
+        else
+            list.head = w;
+        list.tail = w;
+        list.count.fetch_add(1, std::memory_order_seq_cst);
+        // 与__notify中的栅栏配对，避免错过另一端的通知
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!ready())
+            return __wait_result::queued;
+        __unlink(list, w);
+        return __wait_result::ready;
+    }
+
+    void __unlink(__waiter_list& list, __waiter* w)noexcept {
+        if(w->_prev)
+            w->_prev->_next = w->_next;
+        else
+            list.head = w->_next;
+        if(w->_next)
+            w->_next->_prev = w->_prev;
+        else
+            list.tail = w->_prev;
+        w->_next = w->_prev = nullptr;
+        w->_queued = false;
+        list.count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // 返回true表示w仍在队列中并已被移除
+    bool __remove_waiter(__waiter_list& list, __waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        __unlink(list, w);
+        return true;
+    }
+
+    // 快路径上只读一次计数，没有等待者时不加锁
+    void __notify(__waiter_list& list, std::size_t n)noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(list.count.load(std::memory_order_relaxed) == 0)
+            return;
+        __waiter* woken = nullptr;
+        {
+            std::lock_guard lk{_mtx};
+            while(n-- > 0 && list.head){
+                __waiter* w = list.head;
+                __unlink(list, w);
+                w->_next = woken;
+                woken = w;
+            }
+        }
+        while(woken){
+            __waiter* next = woken->_next;
+            woken->_next = nullptr;
+            woken->_wake(woken);
+            woken = next;
+        }
+    }
+
+    const std::size_t _mask;
+    std::unique_ptr<__cell[]> _cells;
+    alignas(64) std::atomic<std::size_t> _enqueue{0};
+    alignas(64) std::atomic<std::size_t> _dequeue{0};
+    alignas(64) std::atomic<bool> _closed{false};
+    std::mutex _mtx{};
+    __waiter_list _senders{};
+    __waiter_list _receivers{};
+};
+
+// 等待与唤醒的公共部分：Derived::__attempt()返回true表示已经完成
+template<class T>
+template<class Derived, class R>
+struct channel<T>::__op_base: channel<T>::__waiter {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __op_base* self;
+        void operator()()noexcept {
+            if(self->_ch->__remove_waiter(self->__list(), self))
+                self->__complete_stopped();
+        }
+    };
+
+    struct __wake_receiver {
+        using receiver_concept = __ex::receiver_t;
+
+        __op_base* self;
+
+        // 先销毁唤醒操作，之后再次入队时唤醒方才能重新构造它
+        void set_value()&& noexcept {
+            auto* op = self;
+            op->_wake_op.reset();
+            op->__run();
+        }
+
+        template<class E>
+        void set_error(E&& e)&& noexcept {
+            self->_stop_callback.reset();
+            if constexpr(std::is_same_v<std::decay_t<E>, std::exception_ptr>)
+                __ex::set_error(std::move(self->_r), std::forward<E>(e));
+            else
+                __ex::set_error(std::move(self->_r), std::make_exception_ptr(std::forward<E>(e)));
+        }
+
+        void set_stopped()&& noexcept {
+            self->__complete_stopped();
+        }
+
+        __ex::env_of_t<R> get_env()const noexcept {
+            return __ex::get_env(self->_r);
+        }
+    };
+
+    static auto __scheduler_of(const R& r)noexcept {
+        if constexpr(requires { __ex::get_scheduler(__ex::get_env(r)); })
+            return __ex::get_scheduler(__ex::get_env(r));
+        else
+            return __detail::__empty_t{};
+    }
+
+    using __scheduler_t = decltype(__scheduler_of(std::declval<const R&>()));
+    static constexpr bool __has_scheduler = !std::is_same_v<__scheduler_t, __detail::__empty_t>;
+
+    template<class S>
+    struct __wake_op_of {
+        using type = __ex::connect_result_t<__ex::schedule_result_t<S&>, __wake_receiver>;
+    };
+
+    template<class S>
+        requires std::is_same_v<S, __detail::__empty_t>
+    struct __wake_op_of<S> {
+        using type = __detail::__empty_t;
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    channel* _ch;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+    std::optional<typename __wake_op_of<__scheduler_t>::type> _wake_op{};
+
+    template<class _R>
+    __op_base(channel* ch, _R&& r):
+        _ch{ch},
+        _r{std::forward<_R>(r)}
+    {
+        this->_wake = [](__waiter* w)noexcept {
+            auto* self = static_cast<__op_base*>(w);
+            if constexpr(__has_scheduler){
+                // 在等待者自己的调度器上重试
+                try{
+                    self->_wake_op.emplace(__detail::__conv{[self]{
+                        return __ex::connect(__ex::schedule(__scheduler_of(self->_r)), __wake_receiver{self});
+                    }});
+                }catch(...){
+                    self->_stop_callback.reset();
+                    __ex::set_error(std::move(self->_r), std::current_exception());
+                    return;
+                }
+                __ex::start(*self->_wake_op);
+            }else{
+                self->__run();
+            }
+        };
+    }
+
+    __op_base(const __op_base&) = delete;
+    __op_base(__op_base&&) = delete;
+    __op_base& operator=(const __op_base&) = delete;
+    __op_base& operator=(__op_base&&) = delete;
+
+    Derived& __derived()noexcept { return static_cast<Derived&>(*this); }
+
+    __waiter_list& __list()noexcept {
+        return Derived::__is_sender ? _ch->_senders : _ch->_receivers;
+    }
+
+    void __complete_stopped()noexcept {
+        _stop_callback.reset();
+        __ex::set_stopped(std::move(_r));
+    }
+
+    // 被唤醒后经调度器跳转期间到达的停止请求找不到入队的等待者，由再次入队时的检查处理
+    void __run()noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        for(;;){
+            if(__derived().__attempt())
+                return;
+            switch(_ch->__enqueue_waiter(__list(), this, [this]{ return __derived().__ready(); }, st)){
+            case __wait_result::queued:
+                // 入队成功后由唤醒方负责重试
+                return;
+            case __wait_result::stopped:
+                __complete_stopped();
+                return;
+            case __wait_result::ready:
+                break;
+            }
+        }
+    }
+
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        __run();
+    }
+};
+
+template<class T>
+template<class R>
+struct channel<T>::__send_op: channel<T>::template __op_base<__send_op<R>, R> {
+    static constexpr bool __is_sender = true;
+
+    T _value;
+
+    template<class _R>
+    __send_op(channel* ch, T&& value, _R&& r):
+        __send_op::__op_base(ch, std::forward<_R>(r)),
+        _value{std::move(value)}
+    {}
+
+    bool __ready()const noexcept {
+        return !this->_ch->__full() || this->_ch->closed();
+    }
+
+    bool __attempt()noexcept {
+        if(this->_ch->closed()){
+            this->__complete_stopped();
+            return true;
+        }
+        try{
+            if(!this->_ch->__try_push(_value))
+                return false;
+        }catch(...){
+            this->_stop_callback.reset();
+            __ex::set_error(std::move(this->_r), std::current_exception());
+            return true;
+        }
+        this->_ch->__notify(this->_ch->_receivers, 1);
+        this->_stop_callback.reset();
+        __ex::set_value(std::move(this->_r));
+        return true;
+    }
 };
 
-// Copyright Ruslan Arutyunyan, 2019-2021.
-// Copyright Antony Polukhin, 2021-2023.
-//
-// Distributed under the Boost Software License, Version 1.0. (See
-// accompanying file LICENSE_1_0.txt or copy at
-// http://www.boost.org/LICENSE_1_0.txt)
+template<class T>
+template<class R>
+struct channel<T>::__receive_op: channel<T>::template __op_base<__receive_op<R>, R> {
+    static constexpr bool __is_sender = false;
 
-// Contributed by Ruslan Arutyunyan
+    template<class _R>
+    __receive_op(channel* ch, _R&& r):
+        __receive_op::__op_base(ch, std::forward<_R>(r))
+    {}
 
-template <std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
-class basic_any{
-    static_assert(OptimizeForSize > 0 && OptimizeForAlignment > 0, "Size and Align shall be positive values");
-    static_assert(OptimizeForSize >= OptimizeForAlignment, "Size shall non less than Align");
-    static_assert((OptimizeForAlignment & (OptimizeForAlignment - 1)) == 0, "Align shall be a power of 2");
-    static_assert(OptimizeForSize % OptimizeForAlignment == 0, "Size shall be multiple of alignment");
-private:
-    /// @cond
-    enum operation{
-        Destroy,
-        Move,
-        UnsafeCast
+    bool __ready()const noexcept {
+        return !this->_ch->__empty() || this->_ch->closed();
+    }
+
+    bool __attempt()noexcept {
+        std::optional<T> v;
+        try{
+            v = this->_ch->__try_pop();
+        }catch(...){
+            this->_stop_callback.reset();
+            __ex::set_error(std::move(this->_r), std::current_exception());
+            return true;
+        }
+        if(!v){
+            if(!this->_ch->closed())
+                return false;
+            this->__complete_stopped();
+            return true;
+        }
+        this->_ch->__notify(this->_ch->_senders, 1);
+        this->_stop_callback.reset();
+        __ex::set_value(std::move(this->_r), std::move(*v));
+        return true;
+    }
+};
+
+template<class T>
+template<class R>
+struct channel<T>::__receive_batch_op: channel<T>::template __op_base<__receive_batch_op<R>, R> {
+    static constexpr bool __is_sender = false;
+
+    std::span<T> _out;
+
+    template<class _R>
+    __receive_batch_op(channel* ch, std::span<T> out, _R&& r):
+        __receive_batch_op::__op_base(ch, std::forward<_R>(r)),
+        _out{out}
+    {}
+
+    bool __ready()const noexcept {
+        return !this->_ch->__empty() || this->_ch->closed();
+    }
+
+    bool __attempt()noexcept {
+        std::size_t n = 0;
+        try{
+            while(n < _out.size()){
+                auto v = this->_ch->__try_pop();
+                if(!v)
+                    break;
+                _out[n++] = std::move(*v);
+            }
+        }catch(...){
+            this->_stop_callback.reset();
+            __ex::set_error(std::move(this->_r), std::current_exception());
+            return true;
+        }
+        if(n == 0 && !_out.empty()){
+            if(!this->_ch->closed())
+                return false;
+            this->__complete_stopped();
+            return true;
+        }
+        this->_ch->__notify(this->_ch->_senders, n);
+        this->_stop_callback.reset();
+        __ex::set_value(std::move(this->_r), n);
+        return true;
+    }
+};
+
+template<class T>
+template<template<class> class Op, class ValueSig, class... Ts>
+struct channel<T>::__sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        ValueSig,
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    channel* _ch;
+    std::tuple<Ts...> _args;
+
+    template<__ex::receiver R>
+    Op<std::decay_t<R>> connect(R&& r) && {
+        return std::apply([&](Ts&... args){
+            return Op<std::decay_t<R>>{ _ch, std::move(args)..., std::forward<R>(r) };
+        }, _args);
+    }
+};
+
+template<class T>
+auto channel<T>::send(T value) {
+    return __sender<__send_op, __ex::set_value_t(), T>{ this, std::tuple<T>{std::move(value)} };
+}
+
+template<class T>
+auto channel<T>::receive() {
+    return __sender<__receive_op, __ex::set_value_t(T)>{ this, std::tuple<>{} };
+}
+
+template<class T>
+auto channel<T>::receive_batch(std::span<T> out) {
+    return __sender<__receive_batch_op, __ex::set_value_t(std::size_t), std::span<T>>{ this, std::tuple<std::span<T>>{out} };
+}
+
+namespace __detail{
+
+struct __sync_waiter {
+    __sync_waiter* _next = nullptr;
+    __sync_waiter* _prev = nullptr;
+    bool _queued = false;
+    // 一次请求的数量，目前只有rate_limiter使用
+    std::size_t _count = 1;
+    void (*_resume)(__sync_waiter*) noexcept = nullptr;
+};
+
+struct __sync_waiter_list {
+    __sync_waiter* head = nullptr;
+    __sync_waiter* tail = nullptr;
+
+    void push_back(__sync_waiter* w)noexcept {
+        w->_queued = true;
+        w->_next = nullptr;
+        w->_prev = tail;
+        if(tail)
+            tail->_next = w;
+        else
+            head = w;
+        tail = w;
+    }
+
+    __sync_waiter* pop_front()noexcept {
+        __sync_waiter* w = head;
+        if(w)
+            unlink(w);
+        return w;
+    }
+
+    void unlink(__sync_waiter* w)noexcept {
+        if(w->_prev)
+            w->_prev->_next = w->_next;
+        else
+            head = w->_next;
+        if(w->_next)
+            w->_next->_prev = w->_prev;
+        else
+            tail = w->_prev;
+        w->_next = w->_prev = nullptr;
+        w->_queued = false;
+    }
+};
+
+enum struct __enqueue_result: char {
+    acquired, queued, stopped
+};
+
+// 同步原语的等待操作：Primitive提供__try_acquire()或__try_acquire(count)、__enqueue(w, st)、__remove(w)
+// __enqueue在持有锁时检查停止请求，与停止回调中的__remove互斥，保证不会在请求停止之后才入队
+// __enqueue抛出异常时等待者未入队，以set_error完成
+// 被唤醒时已经获得所有权，在等待者环境中的调度器上完成
+template<class Primitive, class R, class ...Values>
+struct __sync_op: __sync_waiter {
+    using operation_state_concept = __ex::operation_state_tag;
+
+    struct __on_stop {
+        __sync_op* self;
+        void operator()()noexcept {
+            if(self->_primitive->__remove(self))
+                __ex::set_stopped(std::move(self->_r));
+        }
     };
 
-    template <typename ValueType>
-    static void* small_manager(operation op, basic_any& left, const basic_any* right){
-        switch (op)
-        {
-            case Destroy:
-                reinterpret_cast<ValueType*>(&left.content.small_value)->~ValueType();
-                break;
-            case Move: {
-                ValueType* value = reinterpret_cast<ValueType*>(&const_cast<basic_any*>(right)->content.small_value);
-                new (&left.content.small_value) ValueType(std::move(*value));
-                left.man = right->man;
-                reinterpret_cast<ValueType const*>(&right->content.small_value)->~ValueType();
-                const_cast<basic_any*>(right)->man = 0;
-            };
-                break;
-            case UnsafeCast:
-                return reinterpret_cast<typename std::remove_cv<ValueType>::type *>(&left.content.small_value);
+    struct __resume_receiver {
+        using receiver_concept = __ex::receiver_t;
+
+        __sync_op* self;
+
+        void set_value()&& noexcept {
+            self->__complete();
         }
-        return 0;
+
+        template<class E>
+        void set_error(E&& e)&& noexcept {
+            self->__release();
+            if constexpr(std::is_same_v<std::decay_t<E>, std::exception_ptr>)
+                __ex::set_error(std::move(self->_r), std::forward<E>(e));
+            else
+                __ex::set_error(std::move(self->_r), std::make_exception_ptr(std::forward<E>(e)));
+        }
+
+        void set_stopped()&& noexcept {
+            self->__release();
+            __ex::set_stopped(std::move(self->_r));
+        }
+
+        __ex::env_of_t<R> get_env()const noexcept {
+            return __ex::get_env(self->_r);
+        }
+    };
+
+    static auto __scheduler_of(const R& r)noexcept {
+        if constexpr(requires { __ex::get_scheduler(__ex::get_env(r)); })
+            return __ex::get_scheduler(__ex::get_env(r));
+        else
+            return __empty_t{};
     }
 
-    template <typename ValueType>
-    static void* large_manager(operation op, basic_any& left, const basic_any* right){
-        switch (op)
+    using __scheduler_t = decltype(__scheduler_of(std::declval<const R&>()));
+    static constexpr bool __has_scheduler = !std::is_same_v<__scheduler_t, __empty_t>;
+
+    template<class S>
+    struct __resume_op_of {
+        using type = __ex::connect_result_t<__ex::schedule_result_t<S&>, __resume_receiver>;
+    };
+
+    template<class S>
+        requires std::is_same_v<S, __empty_t>
+    struct __resume_op_of<S> {
+        using type = __empty_t;
+    };
+
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    Primitive* _primitive;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+    std::optional<typename __resume_op_of<__scheduler_t>::type> _resume_op{};
+
+    template<class _R>
+    __sync_op(Primitive* primitive, _R&& r, std::size_t count = 1):
+        _primitive{primitive},
+        _r{std::forward<_R>(r)}
+    {
+        this->_count = count;
+        this->_resume = [](__sync_waiter* w)noexcept {
+            auto* self = static_cast<__sync_op*>(w);
+            self->_stop_callback.reset();
+            if constexpr(__has_scheduler){
+                try{
+                    self->_resume_op.emplace(__conv{[self]{
+                        return __ex::connect(__ex::schedule(__scheduler_of(self->_r)), __resume_receiver{self});
+                    }});
+                }catch(...){
+                    self->__release();
+                    __ex::set_error(std::move(self->_r), std::current_exception());
+                    return;
+                }
+                __ex::start(*self->_resume_op);
+            }else{
+                self->__complete();
+            }
+        };
+    }
+
+    __sync_op(const __sync_op&) = delete;
+    __sync_op(__sync_op&&) = delete;
+    __sync_op& operator=(const __sync_op&) = delete;
+    __sync_op& operator=(__sync_op&&) = delete;
+
+    void __complete()noexcept {
+        __ex::set_value(std::move(_r), _primitive->__value_of(static_cast<Values*>(nullptr))...);
+    }
+
+    // 已获得所有权却无法交付时归还
+    void __release()noexcept {
+        _primitive->__give_back();
+    }
+
+    bool __try_acquire()noexcept {
+        if constexpr(requires { _primitive->__try_acquire(this->_count); })
+            return _primitive->__try_acquire(this->_count);
+        else
+            return _primitive->__try_acquire();
+    }
+
+    void start() & noexcept {
+        // 无竞争时内联完成
+        if(__try_acquire()){
+            __complete();
+            return;
+        }
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        __enqueue_result result;
+        try{
+            result = _primitive->__enqueue(this, st);
+        }catch(...){
+            _stop_callback.reset();
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
+        }
+        switch(result){
+        case __enqueue_result::acquired:
+            // 入队前又获得了所有权
+            _stop_callback.reset();
+            __complete();
+            break;
+        case __enqueue_result::stopped:
+            _stop_callback.reset();
+            __ex::set_stopped(std::move(_r));
+            break;
+        case __enqueue_result::queued:
+            break;
+        }
+    }
+};
+
+template<class Primitive, class ...Values>
+struct __sync_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(Values...),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
+
+    Primitive* _primitive;
+    std::size_t _count = 1;
+
+    template<__ex::receiver R>
+    __sync_op<Primitive, std::decay_t<R>, Values...> connect(R&& r) && {
+        return { _primitive, std::forward<R>(r), _count };
+    }
+};
+
+}// __detail
+
+// 异步互斥量：未竞争时lock()在调用线程上直接完成；unlock()把所有权直接交给最早的等待者
+class async_mutex {
+public:
+    class lock_guard {
+    public:
+        lock_guard() = default;
+        explicit lock_guard(async_mutex* m)noexcept: _m{m} {}
+        lock_guard(lock_guard&& other)noexcept: _m{std::exchange(other._m, nullptr)} {}
+        lock_guard& operator=(lock_guard&& other)noexcept {
+            if(this != &other){
+                if(_m)
+                    _m->unlock();
+                _m = std::exchange(other._m, nullptr);
+            }
+            return *this;
+        }
+        ~lock_guard() {
+            if(_m)
+                _m->unlock();
+        }
+    private:
+        async_mutex* _m = nullptr;
+    };
+
+    async_mutex() = default;
+    async_mutex(const async_mutex&) = delete;
+    async_mutex& operator=(const async_mutex&) = delete;
+
+    auto lock()noexcept {
+        return __detail::__sync_sender<async_mutex>{ this };
+    }
+
+    // 以lock_guard完成，析构时解锁
+    auto scoped_lock()noexcept {
+        return __detail::__sync_sender<async_mutex, lock_guard>{ this };
+    }
+
+    bool try_lock()noexcept {
+        return __try_acquire();
+    }
+
+    void unlock()noexcept {
+        int expected = __locked;
+        if(_state.compare_exchange_strong(expected, __unlocked, std::memory_order_release, std::memory_order_relaxed))
+            return;
+        __detail::__sync_waiter* w;
         {
-            case Destroy:
-                delete static_cast<ValueType*>(left.content.large_value);
-                break;
-            case Move:
-                left.content.large_value = right->content.large_value;
-                left.man = right->man;
-                const_cast<basic_any*>(right)->content.large_value = 0;
-                const_cast<basic_any*>(right)->man = 0;
+            std::lock_guard lk{_mtx};
+            w = _waiters.pop_front();
+            if(!w)
+                _state.store(__unlocked, std::memory_order_release);
+            else if(!_waiters.head)
+                _state.store(__locked, std::memory_order_relaxed);
+        }
+        if(w)
+            w->_resume(w);
+    }
+
+    // 以下供__sync_op使用
+    bool __try_acquire()noexcept {
+        int expected = __unlocked;
+        return _state.compare_exchange_strong(expected, __locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    template<class StopToken>
+    __detail::__enqueue_result __enqueue(__detail::__sync_waiter* w, const StopToken& st)noexcept {
+        std::lock_guard lk{_mtx};
+        int s = _state.load(std::memory_order_relaxed);
+        for(;;){
+            if(s == __unlocked){
+                if(_state.compare_exchange_weak(s, __locked, std::memory_order_acquire, std::memory_order_relaxed))
+                    return __detail::__enqueue_result::acquired;
+            }else if(s == __contended || _state.compare_exchange_weak(s, __contended, std::memory_order_relaxed)){
                 break;
-            case UnsafeCast:
-                return reinterpret_cast<typename std::remove_cv<ValueType>::type *>(left.content.large_value);
+            }
         }
-        return 0;
+        // 没有等待者时留下的__contended由unlock()的慢路径恢复
+        if(st.stop_requested())
+            return __detail::__enqueue_result::stopped;
+        _waiters.push_back(w);
+        return __detail::__enqueue_result::queued;
     }
 
-    template <typename ValueType>
-    struct is_small_object : std::integral_constant<bool, sizeof(ValueType) <= OptimizeForSize &&
-        alignof(ValueType) <= OptimizeForAlignment &&
-        std::is_nothrow_move_constructible<ValueType>::value>
-    {};
+    bool __remove(__detail::__sync_waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        _waiters.unlink(w);
+        return true;
+    }
 
-    template <typename ValueType>
-    static void create(basic_any& any, ValueType&& value, std::true_type){
-        typedef typename std::decay<const ValueType>::type DecayedType;
-        any.man = &small_manager<DecayedType>;
-        new (&any.content.small_value) DecayedType(std::forward<ValueType>(value));
+    void __give_back()noexcept {
+        unlock();
     }
 
-    template <typename ValueType>
-    static void create(basic_any& any, ValueType&& value, std::false_type){
-        typedef typename std::decay<const ValueType>::type DecayedType;
-        any.man = &large_manager<DecayedType>;
-        any.content.large_value = new DecayedType(std::forward<ValueType>(value));
+    lock_guard __value_of(lock_guard*)noexcept {
+        return lock_guard{this};
     }
-    /// @endcond
+private:
+    static constexpr int __unlocked = 0;
+    static constexpr int __locked = 1;
+    static constexpr int __contended = 2;
 
-public: // non-type template parameters accessors
-        static constexpr std::size_t buffer_size = OptimizeForSize;
-        static constexpr std::size_t buffer_align = OptimizeForAlignment;
+    std::atomic<int> _state{__unlocked};
+    std::mutex _mtx{};
+    __detail::__sync_waiter_list _waiters{};
+};
+
+// 异步计数信号量：有剩余许可时acquire()直接完成
+class counting_semaphore {
+public:
+    explicit counting_semaphore(std::ptrdiff_t initial)noexcept:
+        _count{initial}
+    {}
 
-public: // structors
+    counting_semaphore(const counting_semaphore&) = delete;
+    counting_semaphore& operator=(const counting_semaphore&) = delete;
 
-    /// \post this->empty() is true.
-    constexpr basic_any() noexcept
-        : man(0), content()
-    {
+    auto acquire()noexcept {
+        return __detail::__sync_sender<counting_semaphore>{ this };
     }
 
-    basic_any(basic_any&& other) noexcept
-        : man(0), content()
-    {
-        if (other.man){
-            other.man(Move, *this, &other);
+    bool try_acquire()noexcept {
+        return __try_acquire();
+    }
+
+    void release(std::ptrdiff_t n = 1)noexcept {
+        _count.fetch_add(n, std::memory_order_seq_cst);
+        if(_waiting.load(std::memory_order_seq_cst) == 0)
+            return;
+        __detail::__sync_waiter* woken = nullptr;
+        {
+            std::lock_guard lk{_mtx};
+            // 先替等待者取得许可再唤醒
+            while(_waiters.head && __try_acquire()){
+                __detail::__sync_waiter* w = _waiters.pop_front();
+                _waiting.fetch_sub(1, std::memory_order_relaxed);
+                w->_next = woken;
+                woken = w;
+            }
+        }
+        while(woken){
+            __detail::__sync_waiter* next = woken->_next;
+            woken->_next = nullptr;
+            woken->_resume(woken);
+            woken = next;
         }
     }
 
-    template<typename ValueType>
-    basic_any(ValueType&& value
-        , typename std::enable_if<!std::is_same<basic_any&, ValueType>::value >::type* = 0 // disable if value has type `basic_any&`
-        , typename std::enable_if<!std::is_const<ValueType>::value >::type* = 0) // disable if value has type `const ValueType&&`
-        : man(0), content(){
-        typedef typename std::decay<ValueType>::type DecayedType;
-        static_assert(
-            !std::is_same<DecayedType, basic_any>::value,
-            "basic_any shall not be constructed from basic_any"
-        );
-        create(*this, static_cast<ValueType&&>(value), is_small_object<DecayedType>());
+    std::ptrdiff_t available()const noexcept {
+        return _count.load(std::memory_order_relaxed);
     }
 
-    ~basic_any() noexcept{
-        if (man){
-            man(Destroy, *this, 0);
+    // 以下供__sync_op使用
+    bool __try_acquire()noexcept {
+        std::ptrdiff_t c = _count.load(std::memory_order_relaxed);
+        while(c > 0){
+            if(_count.compare_exchange_weak(c, c - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
         }
+        return false;
     }
 
-public: // modifiers
-    basic_any & swap(basic_any & rhs) noexcept{
-        if (this == &rhs){
-            return *this;
+    template<class StopToken>
+    __detail::__enqueue_result __enqueue(__detail::__sync_waiter* w, const StopToken& st)noexcept {
+        {
+            std::lock_guard lk{_mtx};
+            if(st.stop_requested())
+                return __detail::__enqueue_result::stopped;
+            _waiters.push_back(w);
+            _waiting.fetch_add(1, std::memory_order_seq_cst);
         }
-
-        if (man && rhs.man){
-            basic_any tmp;
-            rhs.man(Move, tmp, &rhs);
-            man(Move, rhs, this);
-            tmp.man(Move, *this, &tmp);
+        // 入队之后再检查一次，避免错过并发的release()
+        if(!__try_acquire())
+            return __detail::__enqueue_result::queued;
+        {
+            std::lock_guard lk{_mtx};
+            if(w->_queued){
+                _waiters.unlink(w);
+                _waiting.fetch_sub(1, std::memory_order_relaxed);
+                return __detail::__enqueue_result::acquired;
+            }
         }
-        else if (man){
-            man(Move, rhs, this);
+        // release()已经替我们取得了许可并会唤醒我们，多取的许可归还
+        release(1);
+        return __detail::__enqueue_result::queued;
+    }
+
+    bool __remove(__detail::__sync_waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        _waiters.unlink(w);
+        _waiting.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void __give_back()noexcept {
+        release(1);
+    }
+private:
+    std::atomic<std::ptrdiff_t> _count;
+    std::atomic<std::size_t> _waiting{0};
+    std::mutex _mtx{};
+    __detail::__sync_waiter_list _waiters{};
+};
+
+// 手动复位事件：set()唤醒所有等待者，直到reset()之前wait()都直接完成
+class manual_reset_event {
+public:
+    explicit manual_reset_event(bool initially_set = false)noexcept:
+        _set{initially_set}
+    {}
+
+    manual_reset_event(const manual_reset_event&) = delete;
+    manual_reset_event& operator=(const manual_reset_event&) = delete;
+
+    auto wait()noexcept {
+        return __detail::__sync_sender<manual_reset_event>{ this };
+    }
+
+    void set()noexcept {
+        __detail::__sync_waiter* waiters;
+        {
+            std::lock_guard lk{_mtx};
+            _set.store(true, std::memory_order_release);
+            waiters = std::exchange(_waiters.head, nullptr);
+            _waiters.tail = nullptr;
+            for(auto* w = waiters; w; w = w->_next)
+                w->_queued = false;
         }
-        else if (rhs.man){
-            rhs.man(Move, *this, &rhs);
+        while(waiters){
+            __detail::__sync_waiter* next = waiters->_next;
+            waiters->_next = waiters->_prev = nullptr;
+            waiters->_resume(waiters);
+            waiters = next;
         }
-        return *this;
     }
 
-    basic_any & operator=(basic_any&& rhs) noexcept{
-        rhs.swap(*this);
-        basic_any().swap(rhs);
-        return *this;
+    void reset()noexcept {
+        _set.store(false, std::memory_order_release);
     }
 
-    template <class ValueType>
-    basic_any & operator=(ValueType&& rhs){
-        typedef typename std::decay<ValueType>::type DecayedType;
-        static_assert(
-            !std::is_same<DecayedType, basic_any>::value,
-            "basic_any shall not be assigned into basic_any"
-        );
-        basic_any(std::forward<ValueType>(rhs)).swap(*this);
-        return *this;
+    bool is_set()const noexcept {
+        return _set.load(std::memory_order_acquire);
     }
 
-public: // queries
-    bool empty() const noexcept{
-        return !man;
+    // 以下供__sync_op使用
+    bool __try_acquire()noexcept {
+        return is_set();
     }
 
-    /// \post this->empty() is true
-    void clear() noexcept{
-        basic_any().swap(*this);
+    template<class StopToken>
+    __detail::__enqueue_result __enqueue(__detail::__sync_waiter* w, const StopToken& st)noexcept {
+        std::lock_guard lk{_mtx};
+        if(_set.load(std::memory_order_relaxed))
+            return __detail::__enqueue_result::acquired;
+        if(st.stop_requested())
+            return __detail::__enqueue_result::stopped;
+        _waiters.push_back(w);
+        return __detail::__enqueue_result::queued;
     }
 
-private: // representation
+    bool __remove(__detail::__sync_waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        _waiters.unlink(w);
+        return true;
+    }
 
-    template<typename ValueType, std::size_t Size, std::size_t Alignment>
-    friend ValueType * unsafe_any_cast(basic_any<Size, Alignment> *) noexcept;
+    void __give_back()noexcept {}
+private:
+    std::atomic<bool> _set;
+    std::mutex _mtx{};
+    __detail::__sync_waiter_list _waiters{};
+};
 
-    typedef void*(*manager)(operation op, basic_any& left, const basic_any* right);
+// 令牌桶限流：每秒补充rate个令牌，最多积累burst个
+// 令牌足够且没有人排队时acquire(n)直接完成，否则在侵入式链表上排队，由一个共享的定时器按需补充并唤醒
+// 超过burst的请求在桶满时放行，差额记为欠账
+class rate_limiter {
+public:
+    rate_limiter(asio_context& ctx, double rate, std::size_t burst):
+        _timer{ctx.context()},
+        _rate{rate > 0 ? rate : 1},
+        _burst{static_cast<double>(std::max<std::size_t>(burst, 1))},
+        _tokens{_burst},
+        _last{std::chrono::steady_clock::now()},
+        _liveness{std::make_shared<__liveness_t>(this)}
+    {}
 
-    manager man;
+    // 等待正在执行的定时器回调结束；随后析构定时器取消等待，已经排队的回调也不再访问限流器
+    ~rate_limiter() {
+        std::lock_guard lk{_liveness->mtx};
+        _liveness->limiter = nullptr;
+    }
 
-    union content {
-        void * large_value;
-        alignas(OptimizeForAlignment) unsigned char small_value[OptimizeForSize];
-    } content;
-    /// @endcond
-};
+    rate_limiter(const rate_limiter&) = delete;
+    rate_limiter& operator=(const rate_limiter&) = delete;
 
-/// Exchange of the contents of `lhs` and `rhs`.
-/// \throws Nothing.
-template<std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
-inline void swap(basic_any<OptimizeForSize, OptimizeForAlignment>& lhs, basic_any<OptimizeForSize, OptimizeForAlignment>& rhs) noexcept{
-    lhs.swap(rhs);
-}
+    auto acquire(std::size_t tokens = 1)noexcept {
+        return __detail::__sync_sender<rate_limiter>{ this, tokens };
+    }
 
-template<typename ValueType, std::size_t OptimizedForSize, std::size_t OptimizeForAlignment>
-inline ValueType * unsafe_any_cast(basic_any<OptimizedForSize, OptimizeForAlignment> * operand) noexcept{
-    return static_cast<ValueType*>(operand->man(basic_any<OptimizedForSize, OptimizeForAlignment>::UnsafeCast, *operand, 0));
-}
+    bool try_acquire(std::size_t tokens = 1)noexcept {
+        return __try_acquire(tokens);
+    }
 
-template<typename ValueType, std::size_t OptimizeForSize, std::size_t OptimizeForAlignment>
-inline const ValueType * unsafe_any_cast(const basic_any<OptimizeForSize, OptimizeForAlignment> * operand) noexcept{
-    return unsafe_any_cast<ValueType>(const_cast<basic_any<OptimizeForSize, OptimizeForAlignment> *>(operand));
-}
+    double available()const noexcept {
+        std::lock_guard lk{_mtx};
+        return _tokens;
+    }
 
-template <class Init, class ...InitArgs>
-struct __initializer {
-    template<class _Init, class ..._InitArgs>
-    explicit __initializer(_Init&& init, _InitArgs&& ...args):
-        _init{std::forward<_Init>(init)},
-        _args{std::forward<_InitArgs>(args)...}
-    {}
+    // 以下供__sync_op使用
+    bool __try_acquire(std::size_t n)noexcept {
+        std::lock_guard lk{_mtx};
+        // 有人排队时不插队
+        if(_waiters.head)
+            return false;
+        return __take(n, std::chrono::steady_clock::now());
+    }
 
-    __initializer(const __initializer&) = delete;
-    __initializer(__initializer&&) = default;
-    __initializer& operator=(const __initializer&) = delete;
-    __initializer& operator=(__initializer&&) = default;
+    // 无法设定定时器时抛出异常，等待者以set_error完成而不是绕过限流
+    template<class StopToken>
+    __detail::__enqueue_result __enqueue(__detail::__sync_waiter* w, const StopToken& st) {
+        bool arm;
+        {
+            std::lock_guard lk{_mtx};
+            if(!_waiters.head && __take(w->_count, std::chrono::steady_clock::now()))
+                return __detail::__enqueue_result::acquired;
+            if(st.stop_requested())
+                return __detail::__enqueue_result::stopped;
+            _waiters.push_back(w);
+            arm = !std::exchange(_timer_armed, true);
+        }
+        if(arm){
+            try{
+                __wait();
+            }catch(...){
+                bool removed;
+                {
+                    std::lock_guard lk{_mtx};
+                    // 已被停止回调移除的等待者由停止回调完成
+                    removed = w->_queued;
+                    if(removed)
+                        _waiters.unlink(w);
+                }
+                // 同一窗口内入队的等待者看到了_timer_armed，替它们再设定一次
+                __rearm();
+                if(removed)
+                    throw;
+            }
+        }
+        return __detail::__enqueue_result::queued;
+    }
 
-    template <class Handler>
-    void operator()(Handler&& h) && {
-        std::apply([this, h = std::forward<Handler>(h)](InitArgs&& ...args) mutable {
-            std::move(_init)(std::move(h), std::move(args)...);
-        }, std::move(_args));
+    bool __remove(__detail::__sync_waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        _waiters.unlink(w);
+        return true;
     }
-private:
-    Init _init;
-    std::tuple<InitArgs...> _args;
-};
 
-template<class ...Args>
-struct __any_initializer{
-    using __any_t = basic_any<512, alignof(std::max_align_t)>;
+    // 唤醒后无法交付时令牌不再归还，限流只会更保守
+    void __give_back()noexcept {}
+
 private:
-    struct __init_base{
-        virtual void init(use_sender_handler_base<Args...>&&) = 0;
-        virtual void init(use_sender_handler<Args...>&&) = 0;
-    };
+    // 持有_mtx时调用
+    void __refill(std::chrono::steady_clock::time_point now)noexcept {
+        const std::chrono::duration<double> elapsed = now - _last;
+        _last = now;
+        _tokens = std::min(_burst, _tokens + elapsed.count() * _rate);
+    }
 
-    template<class Init, class ...InitArgs>
-    struct __init_impl final: __init_base{
-        template<class _Init, class ..._InitArgs>
-        __init_impl(_Init&& init, _InitArgs&& ...args):
-            _init(std::forward<_Init>(init), std::forward<_InitArgs>(args)...)
+    bool __take(std::size_t n, std::chrono::steady_clock::time_point now)noexcept {
+        __refill(now);
+        if(_tokens < std::min(static_cast<double>(n), _burst))
+            return false;
+        _tokens -= static_cast<double>(n);
+        return true;
+    }
+
+    // 由定时器回调共享，析构后limiter为空
+    struct __liveness_t {
+        explicit __liveness_t(rate_limiter* l)noexcept:
+            limiter{l}
         {}
 
-        __init_impl(const __init_impl&) = delete;
-        __init_impl& operator=(const __init_impl&) = delete;
-        __init_impl(__init_impl&&)noexcept = default;
-        __init_impl& operator=(__init_impl&&)noexcept = default;
+        std::mutex mtx{};
+        rate_limiter* limiter;
+    };
 
-        void init(use_sender_handler_base<Args...>&& handler) override{
-            std::move(_init)(std::move(handler));
+    // _timer_armed保证同一时刻只有一方设定定时器，因此可以在任意线程上直接调用
+    // 抛出异常时_timer_armed保持不变，由调用方处理
+    void __wait() {
+        std::chrono::nanoseconds delay{};
+        {
+            std::lock_guard lk{_mtx};
+            if(!_waiters.head){
+                _timer_armed = false;
+                return;
+            }
+            __refill(std::chrono::steady_clock::now());
+            const double need = std::min(static_cast<double>(_waiters.head->_count), _burst) - _tokens;
+            if(need > 0)
+                delay = std::chrono::ceil<std::chrono::nanoseconds>(std::chrono::duration<double>(need / _rate));
         }
+        _timer.expires_after(delay);
+        _timer.async_wait([liveness = _liveness](const __error_code& ec){
+            if(ec == __io::error::operation_aborted)
+                return;
+            __detail::__sync_waiter* woken;
+            {
+                std::lock_guard lk{liveness->mtx};
+                if(!liveness->limiter)
+                    return;
+                woken = liveness->limiter->__on_timer();
+            }
+            // 按排队顺序唤醒，此时不再访问限流器
+            while(woken){
+                __detail::__sync_waiter* next = woken->_next;
+                woken->_next = nullptr;
+                woken->_resume(woken);
+                woken = next;
+            }
+        });
+    }
 
-        void init(use_sender_handler<Args...>&& handler) override{
-            std::move(_init)(std::move(handler));
+    // 仍有等待者时重新设定定时器，失败时再试一次，仍失败则清除_timer_armed，由之后的入队重新设定
+    void __rearm()noexcept {
+        for(int attempt = 0; attempt < 2; ++attempt){
+            try{
+                __wait();
+                return;
+            }catch(...){}
         }
-    private:
-        __initializer<Init, InitArgs...> _init;
-    };
-public:
-    template<class Init, class ...InitArgs>
-    __any_initializer(Init&& init, InitArgs&& ...args){
-        _data = __init_impl<std::decay_t<Init>, std::decay_t<InitArgs>...>(std::forward<Init>(init), std::forward<InitArgs>(args)...);
+        std::lock_guard lk{_mtx};
+        _timer_armed = false;
     }
 
-    template<class Init>
-    __any_initializer(Init&& init){
-        _data = __init_impl<std::decay_t<Init>>(std::forward<Init>(init));
+    // 返回按排队顺序链接的已取得令牌的等待者
+    __detail::__sync_waiter* __on_timer()noexcept {
+        __detail::__sync_waiter* woken = nullptr;
+        __detail::__sync_waiter** tail = &woken;
+        bool more;
+        {
+            std::lock_guard lk{_mtx};
+            const auto now = std::chrono::steady_clock::now();
+            while(_waiters.head && __take(_waiters.head->_count, now)){
+                __detail::__sync_waiter* w = _waiters.pop_front();
+                *tail = w;
+                tail = &w->_next;
+            }
+            more = _waiters.head != nullptr;
+            if(!more)
+                _timer_armed = false;
+        }
+        if(more)
+            __rearm();
+        return woken;
     }
 
-    __any_initializer(const __any_initializer&) = delete;
-    __any_initializer& operator=(const __any_initializer&) = delete;
-    __any_initializer(__any_initializer&&)noexcept = default;
-    __any_initializer& operator=(__any_initializer&&)noexcept = default;
+    __io::steady_timer _timer;
+    const double _rate;
+    const double _burst;
+    mutable std::mutex _mtx{};
+    double _tokens;
+    std::chrono::steady_clock::time_point _last;
+    bool _timer_armed = false;
+    __detail::__sync_waiter_list _waiters{};
+    std::shared_ptr<__liveness_t> _liveness;
+};
 
-    void operator()(use_sender_handler_base<Args...>&& handler){
-        unsafe_any_cast<__init_base>(&_data)->init(std::move(handler));
+namespace __detail{
+
+struct __throttle_closure {
+    rate_limiter* _limiter;
+    std::size_t _tokens;
+
+    // 取得令牌之后才启动sndr
+    template<__ex::sender S>
+    auto operator()(S&& sndr)const {
+        return __ex::let_value(
+            _limiter->acquire(_tokens),
+            [sndr = std::forward<S>(sndr)]()mutable {
+                return std::move(sndr);
+            }
+        );
     }
 
-    void operator()(use_sender_handler<Args...>&& handler){
-        unsafe_any_cast<__init_base>(&_data)->init(std::move(handler));
+    template<__ex::sender S>
+    friend auto operator|(S&& sndr, const __throttle_closure& self) {
+        return self(std::forward<S>(sndr));
     }
-private:
-    __any_t _data;
 };
 
-template<class T>
-concept __is_tuple = requires (T&& t){
-    std::get<0>(t);
-};
+}// __detail
 
-template<class T>
-constexpr decltype(auto) __unwrap_first(T&& t)noexcept{
-    return std::forward<T>(t);
+// sndr | throttle(limiter, n)：每次启动前先从limiter取得n个令牌
+inline __detail::__throttle_closure throttle(rate_limiter& limiter, std::size_t tokens = 1)noexcept {
+    return { &limiter, tokens };
 }
 
-template<__is_tuple T>
-constexpr decltype(auto) __unwrap_first(T&& t)noexcept{
-    return __unwrap_first(std::get<0>(std::forward<T>(t)));
+template<__ex::sender S>
+auto throttle(S&& sndr, rate_limiter& limiter, std::size_t tokens = 1) {
+    return throttle(limiter, tokens)(std::forward<S>(sndr));
 }
 
-template<class T>
-using __unwrap_first_t = std::decay_t<decltype(__unwrap_first(std::declval<T>()))>;
+template<class Socket>
+class connection_pool;
 
-template<__is_tuple T>
-constexpr decltype(auto) __unwrap_tuple(T&& t)noexcept{
-    if constexpr(std::tuple_size<T>{} == size_t(1)){
-        return __unwrap_tuple(std::get<0>(std::forward<T>(t)));
-    }else{
-        return std::forward<T>(t);
+// connection_pool借出的连接，析构时归还；socket已关闭或调用discard()后不再放回池中
+template<class Socket>
+class pooled_connection {
+public:
+    using endpoint_type = typename Socket::endpoint_type;
+
+    pooled_connection() = default;
+
+    pooled_connection(connection_pool<Socket>* pool, const endpoint_type& ep, Socket&& socket):
+        _pool{pool},
+        _endpoint{ep},
+        _socket{std::move(socket)}
+    {}
+
+    pooled_connection(pooled_connection&& other)noexcept:
+        _pool{std::exchange(other._pool, nullptr)},
+        _endpoint{other._endpoint},
+        _socket{std::move(other._socket)}
+    {
+        other._socket.reset();
     }
-}
 
-template<class T>
-constexpr decltype(auto) __unwrap_tuple(T&& t)noexcept{
-    return std::make_tuple(std::forward<T>(t));
-}
+    pooled_connection& operator=(pooled_connection&& other)noexcept {
+        if(this != &other){
+            release();
+            _pool = std::exchange(other._pool, nullptr);
+            _endpoint = other._endpoint;
+            _socket = std::move(other._socket);
+            other._socket.reset();
+        }
+        return *this;
+    }
 
-template<class Init, class ...Args>
-struct __sender{
-    using sender_concept = __ex::sender_tag;
-    using completion_signatures = __ex::completion_signatures<
-        __ex::set_value_t(Args...),
-        __ex::set_error_t(std::exception_ptr),
-        __ex::set_stopped_t()
-    >;
-    using initializer_type = Init;
+    ~pooled_connection() {
+        release();
+    }
+
+    Socket& socket()noexcept { return *_socket; }
+    Socket* operator->()noexcept { return &*_socket; }
+    const endpoint_type& endpoint()const noexcept { return _endpoint; }
+    explicit operator bool()const noexcept { return _socket.has_value(); }
+
+    // 关闭连接，不再放回池中
+    void discard()noexcept {
+        if(_socket){
+            __error_code ec;
+            _socket->close(ec);
+        }
+        release();
+    }
+
+    void release()noexcept;
+
+private:
+    connection_pool<Socket>* _pool = nullptr;
+    endpoint_type _endpoint{};
+    std::optional<Socket> _socket{};
+};
 
-    __sender(initializer_type&& init) noexcept:
-        _init(std::move(init))
+// 按端点复用出站连接：acquire(ep)优先取空闲连接，不足时按需建立，
+// 达到每个端点的上限后在侵入式链表上排队；空闲超过idle_timeout的连接由定时器关闭
+// 析构前所有借出的连接必须已归还
+template<class Socket>
+class connection_pool {
+public:
+    using endpoint_type = typename Socket::endpoint_type;
+    using connection_type = pooled_connection<Socket>;
+
+    explicit connection_pool(
+        asio_context& ctx,
+        std::size_t max_per_endpoint = 8,
+        std::chrono::nanoseconds idle_timeout = std::chrono::seconds(30)
+    ):
+        _ctx{ctx.context()},
+        _timer{ctx.context()},
+        _max_per_endpoint{std::max<std::size_t>(max_per_endpoint, 1)},
+        _idle_timeout{idle_timeout},
+        _liveness{std::make_shared<__liveness_t>(this)}
     {}
 
-    __sender(__sender&&) = default;
-    __sender& operator=(__sender&&) = default;
+    // 等待正在执行的淘汰结束；随后析构定时器取消等待，已经排队的回调也不再访问连接池
+    ~connection_pool() {
+        std::lock_guard lk{_liveness->mtx};
+        _liveness->pool = nullptr;
+    }
 
-    initializer_type _init;
+    connection_pool(const connection_pool&) = delete;
+    connection_pool(connection_pool&&) = delete;
+    connection_pool& operator=(const connection_pool&) = delete;
+    connection_pool& operator=(connection_pool&&) = delete;
 
-    template<__ex::receiver R>
-    struct __operation_base: __op_base<Args...> {
-        using operation_state_concept = __ex::operation_state_tag;
+    // 以(error_code, pooled_connection)完成，建立连接失败时连接为空
+    auto acquire(const endpoint_type& ep)noexcept;
 
-        using __storage_t = std::variant<
-            initializer_type,
-            __sbo_buffer<512>
-        >;
+    std::size_t idle_count(const endpoint_type& ep)const {
+        std::lock_guard lk{_mtx};
+        auto it = _endpoints.find(ep);
+        return it == _endpoints.end() ? 0 : it->second.idle.size();
+    }
 
-        __storage_t _storage;
-        R _r;
+    // 空闲、借出与正在建立的连接总数
+    std::size_t open_count(const endpoint_type& ep)const {
+        std::lock_guard lk{_mtx};
+        auto it = _endpoints.find(ep);
+        return it == _endpoints.end() ? 0 : it->second.open;
+    }
 
-        __operation_base(initializer_type&& i, R&& r):
-            _storage{std::move(i)}, _r{std::move(r)}
-        {}
+private:
+    friend class pooled_connection<Socket>;
 
-        initializer_type& __get_initializer()noexcept{
-            return std::get<0>(_storage);
-        }
+    struct __waiter: __detail::__sync_waiter {
+        endpoint_type _endpoint{};
+        // 被唤醒时若已填入则直接交付，否则由等待者自己建立连接
+        std::optional<Socket> _socket{};
+    };
 
-        __sbo_buffer<512>& __emplace_buffer()noexcept{
-            return _storage.template emplace<1>();
-        }
+    struct __idle_t {
+        Socket socket;
+        std::chrono::steady_clock::time_point since;
+    };
 
-        void __stop()noexcept{
-            __ex::set_stopped(std::move(_r));
-        }
+    struct __endpoint_state {
+        std::size_t open = 0;
+        // 按归还时间排序，借出时取最近归还的
+        std::vector<__idle_t> idle{};
+        __detail::__sync_waiter_list waiters{};
+    };
 
-        void __error()noexcept{
-            __ex::set_error(std::move(_r), std::current_exception());
-        }
+    // 由定时器回调共享，析构后pool为空
+    struct __liveness_t {
+        explicit __liveness_t(connection_pool* p)noexcept:
+            pool{p}
+        {}
 
-        void __init(){
-            auto initializer{std::move(__get_initializer())};
-            std::move(initializer)(use_sender_handler_base<Args...>{
-                .op{this},
-                .allocator{&__emplace_buffer()}
-            });
-        }
+        std::mutex mtx{};
+        connection_pool* pool;
+    };
 
-        void complete(Args ...args)noexcept override{
-            if constexpr (sizeof...(args) == 0) {
-                __ex::set_value(std::move(_r));
-            } else {
-                const auto& res = std::tie(args...);
-                const auto& may_be_ec = __unwrap_first(res);
-                if constexpr(requires { may_be_ec == std::errc::operation_canceled; }){
-                    if(may_be_ec == std::errc::operation_canceled){
-                        __stop();
-                        return;
-                    }
-                }
-                __ex::set_value(std::move(_r), std::move(args)...);
-            }
-        }
+    enum struct __acquire_result: char {
+        ready, connect, queued, stopped
     };
 
-    template<__ex::receiver R>
-    struct __operation final: __operation_base<R> {
-        using operation_state_concept = __ex::operation_state_tag;
+    template<class R>
+    struct __acquire_op;
 
-        __operation(initializer_type&& i, R&& r)
-            : __operation_base<R>(std::move(i), std::move(r))
-        {}
+    struct __acquire_sender;
 
-        enum struct __state_t: char{
-            construction, emplaced, initiated, stopped
-        };
+    template<class StopToken>
+    __acquire_result __acquire(__waiter* w, const StopToken& st) {
+        std::lock_guard lk{_mtx};
+        auto& ep = _endpoints[w->_endpoint];
+        if(!ep.idle.empty()){
+            w->_socket.emplace(std::move(ep.idle.back().socket));
+            ep.idle.pop_back();
+            return __acquire_result::ready;
+        }
+        if(ep.open < _max_per_endpoint){
+            ++ep.open;
+            return __acquire_result::connect;
+        }
+        // 与停止回调中的__remove互斥，保证不会在请求停止之后才入队
+        if(st.stop_requested())
+            return __acquire_result::stopped;
+        ep.waiters.push_back(w);
+        return __acquire_result::queued;
+    }
 
-        __io::cancellation_signal _signal{};
-        std::atomic<__state_t> _state{__state_t::construction};
+    bool __remove(__waiter* w)noexcept {
+        std::lock_guard lk{_mtx};
+        if(!w->_queued)
+            return false;
+        _endpoints.find(w->_endpoint)->second.waiters.unlink(w);
+        return true;
+    }
 
-        struct __stop_t{
-            __operation *self;
-            void operator()()noexcept{
-                __state_t expected = self->_state.load(std::memory_order_relaxed);
-                while(!self->_state.compare_exchange_weak(expected, __state_t::stopped, std::memory_order_acq_rel))
-                {}
-                if(expected == __state_t::initiated){
-                    self->_signal.emit(__io::cancellation_type_t::total);
+    // 归还的连接优先交给最早的等待者
+    void __release(const endpoint_type& ep, Socket&& socket)noexcept {
+        __waiter* w = nullptr;
+        bool arm = false;
+        {
+            std::lock_guard lk{_mtx};
+            auto& st = _endpoints.find(ep)->second;
+            w = static_cast<__waiter*>(st.waiters.pop_front());
+            if(w){
+                w->_socket.emplace(std::move(socket));
+            }else{
+                try{
+                    st.idle.push_back(__idle_t{std::move(socket), std::chrono::steady_clock::now()});
+                }catch(...){
+                    --st.open;
+                    return;
                 }
+                arm = !std::exchange(_timer_armed, true);
             }
-        };
-
-        using __stop_callback_t = typename __ex::stop_token_of_t<__ex::env_of_t<R>&>:: template callback_type<__stop_t>;
-        std::optional<__stop_callback_t> _stop_callback{};
+        }
+        if(w)
+            w->_resume(w);
+        if(arm)
+            __arm_timer(_idle_timeout);
+    }
 
-        void __init(){
-            auto initializer{std::move(this->__get_initializer())};
-            std::move(initializer)(use_sender_handler<Args...>{
-                {
-                    .op{this},
-                    .allocator{&this->__emplace_buffer()}
-                },
-                _signal.slot()
-            });
+    // 连接被关闭：空出的名额让给最早的等待者去建立新连接
+    void __drop(const endpoint_type& ep)noexcept {
+        __waiter* w;
+        {
+            std::lock_guard lk{_mtx};
+            auto it = _endpoints.find(ep);
+            w = static_cast<__waiter*>(it->second.waiters.pop_front());
+            if(!w && --it->second.open == 0)
+                _endpoints.erase(it);
         }
+        if(w)
+            w->_resume(w);
+    }
 
-        void complete(Args ...args)noexcept override{
-            _stop_callback.reset();
-            __operation_base<R>::complete(std::move(args)...);
+    // _timer_armed保证同一时刻只有一方设定定时器，因此可以在任意线程上直接调用
+    void __arm_timer(std::chrono::nanoseconds after)noexcept {
+        try{
+            _timer.expires_after(after);
+            _timer.async_wait([liveness = _liveness](const __error_code& ec){
+                std::lock_guard lk{liveness->mtx};
+                if(ec == __io::error::operation_aborted || !liveness->pool)
+                    return;
+                liveness->pool->__evict();
+            });
+        }catch(...){
+            std::lock_guard lk{_mtx};
+            _timer_armed = false;
         }
+    }
 
-        void start() & noexcept
+    void __evict()noexcept {
+        const auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
         {
-            const auto st = __ex::get_stop_token(__ex::get_env(this->_r));
-            if(st.stop_requested()){
-                this->__stop();
-                return;
-            }
-            _stop_callback.emplace(st, __stop_t{this});
-            __state_t expected = __state_t::construction;
-            if(!_state.compare_exchange_strong(expected, __state_t::emplaced, std::memory_order_acq_rel)){
-                _stop_callback.reset();
-                this->__stop();
-                return;
-            }
-            //初始化IO
-            try{
-                this->__init();
-            }catch(...){
-                _stop_callback.reset();
-                this->__error();
-                return;
+            std::lock_guard lk{_mtx};
+            for(auto it = _endpoints.begin(); it != _endpoints.end();){
+                auto& st = it->second;
+                auto expired = std::find_if(st.idle.begin(), st.idle.end(), [&](const __idle_t& i){
+                    return now - i.since < _idle_timeout;
+                });
+                st.open -= static_cast<std::size_t>(expired - st.idle.begin());
+                st.idle.erase(st.idle.begin(), expired);
+                if(!st.idle.empty())
+                    next = std::min(next, st.idle.front().since + _idle_timeout);
+                if(st.open == 0 && !st.waiters.head)
+                    it = _endpoints.erase(it);
+                else
+                    ++it;
             }
-            // 如果没有请求取消，self._state == __state_t::emplaced
-            expected = __state_t::emplaced;
-            if(!_state.compare_exchange_strong(expected, __state_t::initiated, std::memory_order_acq_rel)){
-                // 已经请求取消，但stop_callback不会发出取消信号（见__stop_t的if分支）
-                _stop_callback.reset();
-                _signal.emit(__io::cancellation_type_t::total);
+            if(next == std::chrono::steady_clock::time_point::max()){
+                _timer_armed = false;
                 return;
             }
         }
-    };
+        __arm_timer(next - now);
+    }
 
-    template<__ex::receiver R>
-    struct __asio_op_without_cancellation final: __operation_base<R> {
-        using operation_state_concept = __ex::operation_state_tag;
+    __io::io_context& _ctx;
+    __io::steady_timer _timer;
+    const std::size_t _max_per_endpoint;
+    const std::chrono::nanoseconds _idle_timeout;
+    mutable std::mutex _mtx{};
+    std::map<endpoint_type, __endpoint_state> _endpoints{};
+    bool _timer_armed = false;
+    std::shared_ptr<__liveness_t> _liveness;
+};
 
-        __asio_op_without_cancellation(initializer_type&& i, R&& r)
-            : __operation_base<R>(std::move(i), std::move(r))
-        {}
+template<class Socket>
+template<class R>
+struct connection_pool<Socket>::__acquire_op: connection_pool<Socket>::__waiter {
+    using operation_state_concept = __ex::operation_state_tag;
 
-        void start() & noexcept{
-            try {
-                this->__init();
-            }
-            catch (...) {
-                this->__error();
-            }
+    enum : int {
+        __idle, __connecting, __stopped
+    };
+
+    struct __on_stop {
+        __acquire_op* self;
+        void operator()()noexcept {
+            const int prev = self->_phase.exchange(__stopped, std::memory_order_acq_rel);
+            if(self->_pool->__remove(self))
+                __ex::set_stopped(std::move(self->_r));
+            else if(prev == __connecting)
+                self->_signal.emit(__io::cancellation_type_t::total);
         }
     };
 
-    struct __transfer_sender {
-        using sender_concept = __ex::sender_tag;
-        using completion_signatures = __ex::completion_signatures<
-            __ex::set_value_t(Args...),
-            __ex::set_error_t(std::exception_ptr),
-            __ex::set_stopped_t()
-        >;
+    struct __handler {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using cancellation_slot_type = __io::cancellation_slot;
 
-        initializer_type _init;
+        __acquire_op* self;
 
-        template<__ex::receiver R>
-        struct __transfer_op_without_cancellation final: __operation_base<R> {
-            using operation_state_concept = __ex::operation_state_tag;
+        allocator_type get_allocator()const noexcept { return allocator_type{&self->_buffer}; }
+        cancellation_slot_type get_cancellation_slot()const noexcept { return self->_signal.slot(); }
 
-            __transfer_op_without_cancellation(initializer_type&& i, R&& r)
-                : __operation_base<R>(std::move(i), std::move(r))
-            {}
+        void operator()(__error_code ec)noexcept {
+            self->_ec = ec;
+            self->__arrive();
+        }
+    };
 
-            void start() & noexcept
-            {
-                try {
-                    this->__init();
-                }
-                catch (...) {
-                    this->__error();
-                }
-            }
+    using __stop_token_t = __ex::stop_token_of_t<__ex::env_of_t<R>>;
+    using __stop_callback_t = typename __stop_token_t::template callback_type<__on_stop>;
+
+    connection_pool* _pool;
+    R _r;
+    std::optional<__stop_callback_t> _stop_callback{};
+    std::atomic<int> _phase{__idle};
+    // 发起连接的线程与完成处理器都到达后才完成
+    std::atomic<int> _arrivals{0};
+    __error_code _ec{};
+    __io::cancellation_signal _signal{};
+    __detail::__sbo_buffer<256> _buffer{ __detail::__env_resource(__ex::get_env(_r)) };
+
+    template<class _R>
+    __acquire_op(connection_pool* pool, const endpoint_type& ep, _R&& r):
+        _pool{pool},
+        _r{std::forward<_R>(r)}
+    {
+        this->_endpoint = ep;
+        this->_resume = [](__detail::__sync_waiter* w)noexcept {
+            auto* self = static_cast<__acquire_op*>(w);
+            if(self->_socket)
+                self->__complete({});
+            else
+                self->__connect();
         };
+    }
 
-        template<__ex::receiver R>
-        __ex::operation_state auto connect(R&& r) && {
-            if constexpr(__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
-                return __transfer_op_without_cancellation<std::decay_t<R>>(
-                    std::move(this->_init),
-                    std::forward<R>(r)
-                );
-            }else{
-                return __operation<std::decay_t<R>>(
-                    std::move(this->_init),
-                    std::forward<R>(r)
-                );
-            }
+    __acquire_op(const __acquire_op&) = delete;
+    __acquire_op(__acquire_op&&) = delete;
+    __acquire_op& operator=(const __acquire_op&) = delete;
+    __acquire_op& operator=(__acquire_op&&) = delete;
+
+    void __complete(__error_code ec)noexcept {
+        _stop_callback.reset();
+        if(this->_socket)
+            __ex::set_value(std::move(_r), ec, connection_type{_pool, this->_endpoint, std::move(*this->_socket)});
+        else
+            __ex::set_value(std::move(_r), ec, connection_type{});
+    }
+
+    void __connect()noexcept {
+        try{
+            this->_socket.emplace(_pool->_ctx);
+            this->_socket->async_connect(this->_endpoint, __handler{this});
+        }catch(...){
+            this->_socket.reset();
+            _stop_callback.reset();
+            _pool->__drop(this->_endpoint);
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
         }
-    };
+        if(_phase.exchange(__connecting, std::memory_order_acq_rel) == __stopped)
+            _signal.emit(__io::cancellation_type_t::total);
+        __arrive();
+    }
 
-    template<__ex::receiver R>
-    __ex::operation_state auto connect(R&& r) &&
-    {
-        const auto& env = __ex::get_env(r);
-        if constexpr(requires { __ex::get_scheduler(env); }){
-            return __ex::connect(
-                __ex::continues_on(__transfer_sender{._init{std::move(this->_init)}}, __ex::get_scheduler(env)),
-                std::forward<R>(r)
-            );
-        }else{
-            if constexpr(__ex::unstoppable_token<__ex::stop_token_of_t<__ex::env_of_t<R>>>){
-                return __asio_op_without_cancellation<std::decay_t<R>>(
-                    std::move(this->_init),
-                    std::forward<R>(r)
-                );
-            }else{
-                return __operation<std::decay_t<R>>(
-                    std::move(this->_init),
-                    std::forward<R>(r)
-                );
+    void __arrive()noexcept {
+        if(_arrivals.fetch_add(1, std::memory_order_acq_rel) != 1)
+            return;
+        _stop_callback.reset();
+        if(_ec){
+            this->_socket.reset();
+            _pool->__drop(this->_endpoint);
+            if(_ec == __io::error::operation_aborted && _phase.load(std::memory_order_acquire) == __stopped){
+                __ex::set_stopped(std::move(_r));
+                return;
             }
         }
+        __complete(_ec);
     }
 
-}; // __sender
+    void start() & noexcept {
+        const auto st = __ex::get_stop_token(__ex::get_env(_r));
+        if(st.stop_requested()){
+            __ex::set_stopped(std::move(_r));
+            return;
+        }
+        if constexpr(!__ex::unstoppable_token<__stop_token_t>)
+            _stop_callback.emplace(st, __on_stop{this});
+        __acquire_result res;
+        try{
+            res = _pool->__acquire(this, st);
+        }catch(...){
+            _stop_callback.reset();
+            __ex::set_error(std::move(_r), std::current_exception());
+            return;
+        }
+        switch(res){
+        case __acquire_result::ready:
+            __complete({});
+            break;
+        case __acquire_result::connect:
+            __connect();
+            break;
+        case __acquire_result::stopped:
+            _stop_callback.reset();
+            __ex::set_stopped(std::move(_r));
+            break;
+        case __acquire_result::queued:
+            break;
+        }
+    }
+};
 
-}// __detail
+template<class Socket>
+struct connection_pool<Socket>::__acquire_sender {
+    using sender_concept = __ex::sender_tag;
+    using completion_signatures = __ex::completion_signatures<
+        __ex::set_value_t(__error_code, connection_type),
+        __ex::set_error_t(std::exception_ptr),
+        __ex::set_stopped_t()
+    >;
 
-template<class ...Args>
-using sender = __detail::__sender<__detail::__any_initializer<Args...>, Args...>;
+    connection_pool* _pool;
+    endpoint_type _endpoint;
 
-template <class Executor>
-using basic_scheduler = __detail::basic_scheduler<Executor>;
+    struct __core_sender {
+        using sender_concept = __ex::sender_tag;
+        using completion_signatures = typename __acquire_sender::completion_signatures;
 
-using scheduler = __detail::basic_scheduler<>;
+        connection_pool* _pool;
+        endpoint_type _endpoint;
 
-static_assert(__ex::scheduler<scheduler>);
+        template<__ex::receiver _R>
+        auto connect(_R&& r) && {
+            return __acquire_op<std::decay_t<_R>>{ _pool, _endpoint, std::forward<_R>(r) };
+        }
+    };
+
+    template<__ex::receiver _R>
+    __ex::operation_state auto connect(_R&& r) && {
+        return __detail::__connect_on_scheduler(__core_sender{_pool, _endpoint}, std::forward<_R>(r));
+    }
+};
+
+template<class Socket>
+auto connection_pool<Socket>::acquire(const endpoint_type& ep)noexcept {
+    return __acquire_sender{ this, ep };
+}
+
+template<class Socket>
+void pooled_connection<Socket>::release()noexcept {
+    if(!_pool)
+        return;
+    auto* pool = std::exchange(_pool, nullptr);
+    if(_socket && _socket->is_open())
+        pool->__release(_endpoint, std::move(*_socket));
+    else
+        pool->__drop(_endpoint);
+    _socket.reset();
+}
 
 }// asio2exec
 
@@ -945,10 +7438,12 @@ namespace boost::asio{
         template<class Initiation, class ...InitArgs>
         static return_type initiate(
             Initiation&& init,
-            asio2exec::use_any_sender_t,
+            asio2exec::use_any_sender_t token,
             InitArgs&& ...args
         ){
             return return_type{asio2exec::__detail::__any_initializer<Args...>(
+                        std::allocator_arg,
+                        token.resource(),
                         std::forward<Initiation>(init),
                         std::forward<InitArgs>(args)...
                     )};
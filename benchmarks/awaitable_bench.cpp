@@ -0,0 +1,82 @@
+#include <stdexec/execution.hpp>
+#include <exec/task.hpp>
+#include <exec/start_detached.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/detached.hpp>
+#include <asio/local/stream_protocol.hpp>
+#include <asio/read.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+
+#include "asio2exec.hpp"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+using socket_t = asio::local::stream_protocol::socket;
+
+constexpr std::size_t iterations = 200'000;
+constexpr std::size_t message_size = 64;
+
+asio::awaitable<void> ping_awaitable(socket_t& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < iterations; ++i){
+        co_await asio::async_write(s, asio::buffer(buf), asio::use_awaitable);
+        co_await asio::async_read(s, asio::buffer(buf), asio::use_awaitable);
+    }
+}
+
+asio::awaitable<void> pong_awaitable(socket_t& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < iterations; ++i){
+        co_await asio::async_read(s, asio::buffer(buf), asio::use_awaitable);
+        co_await asio::async_write(s, asio::buffer(buf), asio::use_awaitable);
+    }
+}
+
+exec::task<void> ping_sender(socket_t& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < iterations; ++i){
+        co_await asio::async_write(s, asio::buffer(buf), use_sender);
+        co_await asio::async_read(s, asio::buffer(buf), use_sender);
+    }
+}
+
+exec::task<void> pong_sender(socket_t& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < iterations; ++i){
+        co_await asio::async_read(s, asio::buffer(buf), use_sender);
+        co_await asio::async_write(s, asio::buffer(buf), use_sender);
+    }
+}
+
+template<class F>
+void measure(const char* name, F&& spawn){
+    asio::io_context ctx{1};
+    socket_t a{ctx}, b{ctx};
+    asio::local::connect_pair(a, b);
+
+    spawn(ctx, a, b);
+    const auto t0 = std::chrono::steady_clock::now();
+    ctx.run();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << name << ": " << static_cast<double>(iterations) / elapsed << " round trips/s ("
+              << elapsed * 1e9 / static_cast<double>(iterations * 4) << " ns/op)\n";
+}
+
+int main(){
+    measure("asio::use_awaitable", [](asio::io_context& ctx, socket_t& a, socket_t& b){
+        asio::co_spawn(ctx, ping_awaitable(a), asio::detached);
+        asio::co_spawn(ctx, pong_awaitable(b), asio::detached);
+    });
+
+    measure("exec::task + use_sender", [](asio::io_context& ctx, socket_t& a, socket_t& b){
+        asio2exec::scheduler sched{ctx};
+        exec::start_detached(ex::starts_on(sched, ping_sender(a)));
+        exec::start_detached(ex::starts_on(sched, pong_sender(b)));
+    });
+}
@@ -0,0 +1,297 @@
+// 回显服务的开环压测：
+//   echo_bench [连接数] [请求字节数] [总请求速率(次/秒)] [持续秒数]
+// 在同一次运行中依次测量两种服务端写法(sender管道 / 协程)与两种asio_context配置：
+//   dedicated  服务端与客户端各自运行在独立的asio_context上
+//   shared     服务端与客户端共享同一个asio_context
+// 请求按固定时间表发出，不等待响应(开环)，延迟从计划发送时刻开始计算，避免协调遗漏
+#include <stdexec/execution.hpp>
+#include <exec/task.hpp>
+#include <exec/repeat_until.hpp>
+#include <exec/start_detached.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+
+#include "asio2exec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <vector>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+using asio::ip::tcp;
+using clock_type = std::chrono::steady_clock;
+
+// HDR风格的对数-线性直方图：每个2的幂区间再等分为128个子桶，相对误差不超过1/128
+class latency_histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 7;
+    static constexpr std::uint64_t sub_bucket_count = std::uint64_t{1} << sub_bucket_bits;
+
+    latency_histogram():
+        _counts((64 - sub_bucket_bits + 1) * sub_bucket_count, 0)
+    {}
+
+    void record(std::uint64_t v)noexcept {
+        ++_counts[__index(v)];
+        ++_total;
+        _max = std::max(_max, v);
+    }
+
+    void merge(const latency_histogram& other)noexcept {
+        for(std::size_t i = 0; i < _counts.size(); ++i)
+            _counts[i] += other._counts[i];
+        _total += other._total;
+        _max = std::max(_max, other._max);
+    }
+
+    // 返回不小于q比例样本的最小桶的上界
+    std::uint64_t percentile(double q)const noexcept {
+        if(_total == 0)
+            return 0;
+        const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * static_cast<double>(_total) + 0.5));
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < _counts.size(); ++i){
+            seen += _counts[i];
+            if(seen >= target)
+                return std::min(__highest(i), _max);
+        }
+        return _max;
+    }
+
+    std::uint64_t count()const noexcept { return _total; }
+    std::uint64_t max()const noexcept { return _max; }
+private:
+    // 小于2*sub_bucket_count的值精确计数，更大的值保留最高的sub_bucket_bits+1位
+    static std::size_t __index(std::uint64_t v)noexcept {
+        if(v < 2 * sub_bucket_count)
+            return static_cast<std::size_t>(v);
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - (sub_bucket_bits + 1);
+        return static_cast<std::size_t>(shift * sub_bucket_count + (v >> shift));
+    }
+
+    static std::uint64_t __highest(std::size_t i)noexcept {
+        if(i < 2 * sub_bucket_count)
+            return i;
+        const auto shift = static_cast<unsigned>(i / sub_bucket_count) - 1;
+        const auto mantissa = i - shift * sub_bucket_count;
+        return ((static_cast<std::uint64_t>(mantissa) + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> _counts;
+    std::uint64_t _total{0};
+    std::uint64_t _max{0};
+};
+
+struct bench_options {
+    std::size_t connections{16};
+    std::size_t request_size{64};
+    double rate{50'000.0};
+    double seconds{5.0};
+};
+
+// 与examples/echo_server.cpp相同的sender管道写法，去掉了超时与日志
+void start_sender_server(tcp::acceptor& acceptor, asio2exec::scheduler sched){
+    auto work = ex::schedule(sched) |
+                ex::let_value([&acceptor]{
+                    return acceptor.async_accept(use_sender) |
+                            ex::then([](auto ec, tcp::socket socket){
+                                if(ec)
+                                    throw asio::system_error{ec};
+                                return socket;
+                            });
+                }) |
+                ex::then([sched](tcp::socket socket){
+                    socket.set_option(tcp::no_delay{true});
+                    auto echo_work = ex::just(std::move(socket), std::array<char, 4096>{}) |
+                                    ex::let_value([](tcp::socket& s, std::array<char, 4096>& buf){
+                                        return  ex::just() |
+                                                ex::let_value([&]{
+                                                    return s.async_read_some(asio::buffer(buf), use_sender);
+                                                }) |
+                                                ex::let_value([&](asio::error_code ec, std::size_t n){
+                                                    if(ec)
+                                                        throw asio::system_error{ec};
+                                                    return asio::async_write(s, asio::buffer(buf.data(), n), use_sender);
+                                                }) |
+                                                ex::then([](asio::error_code ec, std::size_t){
+                                                    if(ec)
+                                                        throw asio::system_error{ec};
+                                                    return false;
+                                                }) |
+                                                ex::upon_error([](auto){
+                                                    return true;
+                                                }) |
+                                                exec::repeat_until();
+                                    });
+                    exec::start_detached(ex::starts_on(sched, std::move(echo_work)));
+                    return false;
+                }) |
+                ex::upon_error([](auto){
+                    return true;
+                }) |
+                exec::repeat_until();
+
+    exec::start_detached(std::move(work));
+}
+
+// 与examples/echo_server_coro.cpp相同的协程写法
+exec::task<void> coro_session(tcp::socket s){
+    std::array<char, 4096> buf;
+    s.set_option(tcp::no_delay{true});
+    for(;;){
+        auto [ec, n] = co_await s.async_read_some(asio::buffer(buf), use_sender);
+        if(ec)
+            co_return;
+        std::tie(ec, n) = co_await asio::async_write(s, asio::buffer(buf.data(), n), use_sender);
+        if(ec)
+            co_return;
+    }
+}
+
+exec::task<void> coro_accept(tcp::acceptor& acceptor, asio2exec::scheduler sched){
+    for(;;){
+        auto [ec, sock] = co_await acceptor.async_accept(use_sender);
+        if(ec)
+            co_return;
+        exec::start_detached(ex::starts_on(sched, coro_session(std::move(sock))));
+    }
+}
+
+void start_coro_server(tcp::acceptor& acceptor, asio2exec::scheduler sched){
+    exec::start_detached(ex::starts_on(sched, coro_accept(acceptor, sched)));
+}
+
+// 按时间表写出请求，不等待响应
+exec::task<void> send_loop(tcp::socket& s, clock_type::time_point start, std::chrono::nanoseconds interval,
+                           std::size_t requests, const std::vector<char>& payload){
+    asio::steady_timer timer{s.get_executor()};
+    for(std::size_t i = 0; i < requests; ++i){
+        timer.expires_at(start + interval * static_cast<std::int64_t>(i));
+        co_await timer.async_wait(use_sender);
+        auto [ec, n] = co_await asio::async_write(s, asio::buffer(payload), use_sender);
+        if(ec)
+            throw asio::system_error{ec};
+    }
+}
+
+// 回显按序返回，第i个响应对应第i个计划发送时刻
+exec::task<void> receive_loop(tcp::socket& s, clock_type::time_point start, std::chrono::nanoseconds interval,
+                              std::size_t requests, std::size_t request_size,
+                              latency_histogram& hist, clock_type::time_point& last){
+    std::vector<char> buf(request_size);
+    for(std::size_t i = 0; i < requests; ++i){
+        auto [ec, n] = co_await asio::async_read(s, asio::buffer(buf), use_sender);
+        if(ec)
+            throw asio::system_error{ec};
+        last = clock_type::now();
+        const auto intended = start + interval * static_cast<std::int64_t>(i);
+        hist.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, (last - intended).count())));
+    }
+}
+
+struct connection_state {
+    tcp::socket socket;
+    latency_histogram hist{};
+    clock_type::time_point last{};
+};
+
+using server_starter = void(*)(tcp::acceptor&, asio2exec::scheduler);
+
+void run(const char* server_name, server_starter start_server, bool shared, const bench_options& opt){
+    auto server_ctx = std::make_unique<asio_context>();
+    auto client_ctx = shared ? std::unique_ptr<asio_context>{} : std::make_unique<asio_context>();
+    asio_context& client = shared ? *server_ctx : *client_ctx;
+    server_ctx->start();
+    if(!shared)
+        client.start();
+
+    tcp::acceptor acceptor{server_ctx->context(), tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+    start_server(acceptor, asio2exec::scheduler{server_ctx->context()});
+
+    std::vector<std::unique_ptr<connection_state>> conns;
+    for(std::size_t i = 0; i < opt.connections; ++i){
+        auto c = std::make_unique<connection_state>(tcp::socket{client.context()});
+        c->socket.connect(acceptor.local_endpoint());
+        c->socket.set_option(tcp::no_delay{true});
+        conns.push_back(std::move(c));
+    }
+
+    // 每条连接承担总速率的1/connections，各连接的时间表错开以免同时发送
+    const auto per_conn_rate = opt.rate / static_cast<double>(opt.connections);
+    // 速率低于每连接每次运行一个请求时至少发一个，否则没有样本可统计
+    const auto requests = std::max<std::size_t>(1, static_cast<std::size_t>(per_conn_rate * opt.seconds));
+    const std::chrono::nanoseconds interval{static_cast<std::int64_t>(1e9 / per_conn_rate)};
+    const std::vector<char> payload(opt.request_size, 'x');
+    const auto start = clock_type::now() + std::chrono::milliseconds(50);
+
+    std::latch done{static_cast<std::ptrdiff_t>(opt.connections)};
+    asio2exec::scheduler sched{client.context()};
+    for(std::size_t i = 0; i < opt.connections; ++i){
+        auto& c = *conns[i];
+        const auto offset = interval * static_cast<std::int64_t>(i) / static_cast<std::int64_t>(opt.connections);
+        exec::start_detached(
+            ex::when_all(
+                ex::starts_on(sched, send_loop(c.socket, start + offset, interval, requests, payload)),
+                ex::starts_on(sched, receive_loop(c.socket, start + offset, interval, requests, opt.request_size, c.hist, c.last))
+            ) |
+            ex::upon_error([](auto){
+                std::cerr << "connection failed\n";
+            }) |
+            ex::then([&done]{
+                done.count_down();
+            })
+        );
+    }
+    done.wait();
+
+    latency_histogram total;
+    auto finish = start;
+    for(auto& c : conns){
+        total.merge(c->hist);
+        finish = std::max(finish, c->last);
+        asio::post(client.context(), [&c]{ c->socket.close(); });
+    }
+    asio::post(server_ctx->context(), [&acceptor]{ acceptor.close(); });
+
+    const auto elapsed = std::chrono::duration<double>(finish - start).count();
+    auto us = [](std::uint64_t ns){ return static_cast<double>(ns) / 1e3; };
+    std::cout << std::left << std::setw(10) << server_name << std::setw(10) << (shared ? "shared" : "dedicated")
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << static_cast<double>(total.count()) / elapsed << " req/s"
+              << std::setprecision(1)
+              << "  p50 " << std::setw(9) << us(total.percentile(0.5))
+              << "  p99 " << std::setw(9) << us(total.percentile(0.99))
+              << "  p999 " << std::setw(9) << us(total.percentile(0.999))
+              << "  max " << std::setw(9) << us(total.max()) << " us\n";
+
+    if(client_ctx)
+        client_ctx->join();
+    server_ctx->join();
+}
+
+int main(int argc, char **argv){
+    bench_options opt;
+    if(argc > 1) opt.connections = std::max<std::size_t>(1, std::strtoull(argv[1], nullptr, 10));
+    if(argc > 2) opt.request_size = std::max<std::size_t>(1, std::strtoull(argv[2], nullptr, 10));
+    if(argc > 3) opt.rate = std::max(1.0, std::atof(argv[3]));
+    if(argc > 4) opt.seconds = std::max(0.1, std::atof(argv[4]));
+
+    std::cout << opt.connections << " connections, " << opt.request_size << " bytes/request, "
+              << opt.rate << " req/s target, " << opt.seconds << " s\n";
+
+    run("sender", start_sender_server, false, opt);
+    run("coro", start_coro_server, false, opt);
+    run("sender", start_sender_server, true, opt);
+    run("coro", start_coro_server, true, opt);
+}
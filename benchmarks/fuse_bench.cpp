@@ -0,0 +1,59 @@
+#include <stdexec/execution.hpp>
+#include <asio/post.hpp>
+
+#include "asio2exec.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+
+constexpr std::size_t iterations = 100'000;
+
+// 四步post链：let_value的每一步都连接并启动一个新的操作，各自登记停止回调与SBO内存
+ex::sender auto let_value_chain(asio::io_context& ctx){
+    auto step = [&ctx]{ return asio::post(ctx, use_sender); };
+    return asio::post(ctx, use_sender)
+         | ex::let_value(step)
+         | ex::let_value(step)
+         | ex::let_value(step);
+}
+
+#if defined(ASIO_TO_EXEC_HAS_DEFERRED)
+// 同样的四步在fuse的一个操作状态中完成
+ex::sender auto fused_chain(asio::io_context& ctx){
+    auto step = [&ctx]{ return asio::post(ctx, asio::deferred); };
+    return fuse(asio::post(ctx, asio::deferred), step, step, step);
+}
+#endif
+
+template<class Make>
+void measure(const char* name, asio_context& ctx, Make&& make){
+    const auto t0 = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < iterations; ++i)
+        ex::sync_wait(make(ctx.context()));
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << name << ": " << elapsed * 1e9 / iterations << " ns/chain, "
+              << static_cast<double>(iterations) / elapsed << " chains/s\n";
+}
+
+int main(){
+    asio_context ctx;
+    ctx.start();
+
+    // 先各跑一轮预热
+    measure("let_value (warmup)", ctx, [](asio::io_context& c){ return let_value_chain(c); });
+#if defined(ASIO_TO_EXEC_HAS_DEFERRED)
+    measure("fuse (warmup)", ctx, [](asio::io_context& c){ return fused_chain(c); });
+#endif
+
+    measure("let_value", ctx, [](asio::io_context& c){ return let_value_chain(c); });
+#if defined(ASIO_TO_EXEC_HAS_DEFERRED)
+    measure("fuse", ctx, [](asio::io_context& c){ return fused_chain(c); });
+#else
+    // fuse需要asio::deferred(asio 1.24及以上)
+    std::cout << "fuse: skipped, asio::deferred is not available\n";
+#endif
+}
@@ -0,0 +1,139 @@
+// 对比epoll与io_uring后端：
+//   io_backend_bench        默认(epoll)
+//   io_backend_bench_uring  由CMake为整个翻译单元定义ASIO_HAS_IO_URING与ASIO_DISABLE_EPOLL
+// 每次操作的系统调用数可用 `strace -c -f ./io_backend_bench` 统计后除以输出的操作数得到
+#include <stdexec/execution.hpp>
+#include <exec/task.hpp>
+#include <exec/start_detached.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#include <asio/random_access_file.hpp>
+
+#include "asio2exec.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+using asio::ip::tcp;
+
+constexpr std::size_t round_trips = 200'000;
+constexpr std::size_t message_size = 64;
+constexpr std::size_t file_size = 64 * 1024 * 1024;
+constexpr std::size_t block_size = 4096;
+constexpr std::size_t file_reads = 200'000;
+
+exec::task<void> ping(tcp::socket& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < round_trips; ++i){
+        co_await asio::async_write(s, asio::buffer(buf), use_sender);
+        co_await asio::async_read(s, asio::buffer(buf), use_sender);
+    }
+}
+
+exec::task<void> pong(tcp::socket& s){
+    std::array<char, message_size> buf{};
+    for(std::size_t i = 0; i < round_trips; ++i){
+        co_await asio::async_read(s, asio::buffer(buf), use_sender);
+        co_await asio::async_write(s, asio::buffer(buf), use_sender);
+    }
+}
+
+#if defined(ASIO_HAS_FILE)
+exec::task<void> read_blocks(asio::io_context& ctx, const std::string& path, std::size_t& bytes){
+    asio::random_access_file file{ctx, path, asio::random_access_file::read_only};
+    std::vector<char> buf(block_size);
+    std::mt19937_64 rng{42};
+    for(std::size_t i = 0; i < file_reads; ++i){
+        const auto offset = (rng() % (file_size / block_size)) * block_size;
+        auto [ec, n] = co_await file.async_read_some_at(offset, asio::buffer(buf), use_sender);
+        if(ec)
+            throw asio::system_error{ec};
+        bytes += n;
+    }
+}
+#else
+// epoll无法等待普通文件就绪，基线是在io线程上直接调用pread
+exec::task<void> read_blocks(asio::io_context& ctx, const std::string& path, std::size_t& bytes){
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::system_error{errno, std::generic_category()};
+    std::vector<char> buf(block_size);
+    std::mt19937_64 rng{42};
+    asio2exec::scheduler sched{ctx};
+    for(std::size_t i = 0; i < file_reads; ++i){
+        const auto offset = (rng() % (file_size / block_size)) * block_size;
+        co_await ex::schedule(sched);
+        const auto n = ::pread(fd, buf.data(), buf.size(), static_cast<off_t>(offset));
+        if(n < 0){
+            ::close(fd);
+            throw std::system_error{errno, std::generic_category()};
+        }
+        bytes += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+}
+#endif
+
+void tcp_bench(){
+    asio::io_context ctx{1};
+    tcp::acceptor acceptor{ctx, tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+    tcp::socket a{ctx}, b{ctx};
+    a.connect(acceptor.local_endpoint());
+    acceptor.accept(b);
+    a.set_option(tcp::no_delay{true});
+    b.set_option(tcp::no_delay{true});
+
+    asio2exec::scheduler sched{ctx};
+    exec::start_detached(ex::starts_on(sched, ping(a)));
+    exec::start_detached(ex::starts_on(sched, pong(b)));
+
+    const auto t0 = std::chrono::steady_clock::now();
+    ctx.run();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "loopback tcp: " << round_trips * 4 << " ops, "
+              << static_cast<double>(round_trips) / elapsed << " round trips/s ("
+              << elapsed * 1e9 / static_cast<double>(round_trips * 4) << " ns/op)\n";
+}
+
+void file_bench(){
+    const auto path = (std::filesystem::temp_directory_path() / "asio2exec_io_backend_bench.bin").string();
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        std::vector<char> chunk(1024 * 1024, 'x');
+        for(std::size_t i = 0; i < file_size / chunk.size(); ++i)
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    asio::io_context ctx{1};
+    std::size_t bytes = 0;
+    asio2exec::scheduler sched{ctx};
+    exec::start_detached(ex::starts_on(sched, read_blocks(ctx, path, bytes)));
+
+    const auto t0 = std::chrono::steady_clock::now();
+    ctx.run();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "file pread " << block_size << "B: " << file_reads << " ops, "
+              << static_cast<double>(file_reads) / elapsed << " reads/s, "
+              << static_cast<double>(bytes) / elapsed / (1024 * 1024) << " MiB/s\n";
+    std::filesystem::remove(path);
+}
+
+int main(){
+    std::cout << "backend: " << (asio_context::uses_io_uring() ? "io_uring" : "epoll") << '\n';
+    tcp_bench();
+    file_bench();
+}
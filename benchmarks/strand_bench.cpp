@@ -0,0 +1,95 @@
+#include <stdexec/execution.hpp>
+#include <asio/strand.hpp>
+
+#include "asio2exec.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+
+constexpr std::size_t chains = 8;
+constexpr std::size_t hops = 200'000;
+constexpr std::size_t threads = 4;
+
+// 每条链在同一个调度器上反复schedule，累加一个非原子计数器
+template<class Scheduler>
+struct chain {
+    struct receiver {
+        using receiver_concept = ex::receiver_t;
+
+        chain* self;
+
+        void set_value() && noexcept {
+            ++*self->counter;
+            if(++self->done < hops)
+                self->next();
+        }
+
+        void set_stopped() && noexcept {}
+        void set_error(std::exception_ptr) && noexcept {}
+    };
+
+    using op_t = ex::connect_result_t<ex::schedule_result_t<Scheduler&>, receiver>;
+
+    struct holder {
+        op_t op;
+
+        template<class F>
+        explicit holder(F&& make): op{make()} {}
+    };
+
+    Scheduler sched;
+    std::size_t* counter;
+    std::size_t done = 0;
+    std::optional<holder> op{};
+
+    chain(Scheduler s, std::size_t* c): sched{std::move(s)}, counter{c} {}
+
+    void next() {
+        op.reset();
+        op.emplace([this]{ return ex::connect(ex::schedule(sched), receiver{this}); });
+        ex::start(op->op);
+    }
+};
+
+template<class Scheduler, class Make>
+void measure(const char* name, Make&& make){
+    asio::io_context ctx{static_cast<int>(threads)};
+    std::size_t counter = 0;
+    Scheduler sched = make(ctx);
+    std::vector<std::unique_ptr<chain<Scheduler>>> cs;
+    for(std::size_t i = 0; i < chains; ++i){
+        cs.push_back(std::make_unique<chain<Scheduler>>(sched, &counter));
+        asio::post(ctx, [c = cs.back().get()]{ c->next(); });
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ts;
+    for(std::size_t i = 0; i < threads; ++i)
+        ts.emplace_back([&]{ ctx.run(); });
+    for(auto& t: ts)
+        t.join();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << name << ": " << static_cast<double>(chains * hops) / elapsed << " schedules/s ("
+              << elapsed * 1e9 / static_cast<double>(chains * hops) << " ns/schedule), counter "
+              << (counter == chains * hops ? "ok" : "RACED") << '\n';
+}
+
+int main(){
+    using strand_t = asio::strand<asio::io_context::executor_type>;
+
+    measure<basic_scheduler<strand_t>>("basic_scheduler<strand>", [](asio::io_context& ctx){
+        return basic_scheduler<strand_t>{ asio::make_strand(ctx) };
+    });
+
+    measure<strand_scheduler>("strand_scheduler", [](asio::io_context& ctx){
+        return strand_scheduler{ ctx };
+    });
+}
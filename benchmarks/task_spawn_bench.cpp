@@ -0,0 +1,56 @@
+#include <stdexec/execution.hpp>
+#include <exec/task.hpp>
+#include <exec/start_detached.hpp>
+
+#include "asio2exec.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+
+constexpr std::size_t spawns = 1'000'000;
+
+std::size_t completed = 0;
+
+exec::task<int> child_exec(int i){
+    co_return i;
+}
+
+exec::task<void> session_exec(int i){
+    completed += static_cast<std::size_t>(co_await child_exec(i) >= 0);
+}
+
+asio2exec::task<int> child_pooled(int i){
+    co_return i;
+}
+
+asio2exec::task<void> session_pooled(int i){
+    completed += static_cast<std::size_t>(co_await child_pooled(i) >= 0);
+}
+
+template<class F>
+void measure(const char* name, F&& session){
+    asio::io_context ctx{1};
+    asio_context::scheduler_type sched{ctx};
+    completed = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < spawns; ++i)
+        exec::start_detached(ex::starts_on(sched, session(static_cast<int>(i))));
+    ctx.run();
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << name << ": " << static_cast<double>(completed) / elapsed << " spawns/s ("
+              << elapsed * 1e9 / static_cast<double>(completed) << " ns/spawn)\n";
+}
+
+int main(){
+    measure("exec::task", [](int i){ return session_exec(i); });
+    measure("asio2exec::task", [](int i){ return session_pooled(i); });
+
+    const auto stats = task_frame_statistics();
+    std::cout << "asio2exec::task frames: " << stats.allocations << " allocations, "
+              << stats.recycled << " recycled, " << stats.upstream << " from upstream\n";
+}
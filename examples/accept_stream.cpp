@@ -0,0 +1,52 @@
+#include <stdexec/execution.hpp>
+#include <exec/sequence/transform_each.hpp>
+#include <exec/sequence/ignore_all_values.hpp>
+#include <exec/start_detached.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/write.hpp>
+
+#include "asio2exec.hpp"
+
+#include <array>
+#include <iostream>
+#include <memory>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+
+ex::sender auto echo_once(asio::ip::tcp::socket socket){
+    auto state = std::make_unique<std::pair<asio::ip::tcp::socket, std::array<char, 1024>>>(std::move(socket), std::array<char, 1024>{});
+    auto& [s, buf] = *state;
+    return s.async_read_some(asio::buffer(buf), use_sender) |
+           ex::let_value([&s, &buf](asio::error_code ec, std::size_t n){
+               if(ec)
+                   throw asio::system_error{ec};
+               return asio::async_write(s, asio::buffer(buf.data(), n), use_sender);
+           }) |
+           ex::then([state = std::move(state)](asio::error_code, std::size_t){});
+}
+
+int main(int argc, char **argv){
+    if(argc < 3){
+        std::cout << "Usage: accept_stream <IP> <PORT>\n";
+        return -1;
+    }
+
+    const std::string_view ip{argv[1]};
+    const int port{std::atoi(argv[2])};
+
+    asio::io_context ctx;
+
+    asio2exec::scheduler sched{ctx};
+    asio::ip::tcp::acceptor acceptor{ ctx, asio::ip::tcp::endpoint(asio::ip::make_address_v4(ip), port) };
+
+    // 同一个操作状态持续接受连接，就绪的连接每次最多批量取走16个
+    auto work = accept_stream(acceptor, 16) |
+                exec::transform_each(ex::then([&](asio::ip::tcp::socket socket){
+                    exec::start_detached(ex::starts_on(sched, echo_once(std::move(socket))));
+                })) |
+                exec::ignore_all_values();
+
+    exec::start_detached(std::move(work));
+    ctx.run();
+}
@@ -0,0 +1,38 @@
+#include <stdexec/execution.hpp>
+#include <asio/post.hpp>
+
+#include "asio2exec.hpp"
+
+#include <iostream>
+
+namespace ex = stdexec;
+using namespace std::chrono_literals;
+
+int main() {
+    asio2exec::asio_context ctx;
+    ctx.start();
+
+    asio2exec::lag_probe probe{ctx, 1ms};
+    probe.start();
+
+    const asio2exec::admission_policy policy{ &probe, 5ms };
+
+    // 模拟过载：阻塞事件循环
+    for(int i = 0; i < 20; ++i){
+        asio::post(ctx.context(), []{
+            std::this_thread::sleep_for(10ms);
+        });
+    }
+    std::this_thread::sleep_for(100ms);
+
+    for(int i = 0; i < 5; ++i){
+        auto [admitted] = ex::sync_wait(
+            asio2exec::admit(ctx.get_scheduler(), policy) |
+            ex::then([]{ return true; }) |
+            ex::upon_stopped([]{ return false; })
+        ).value();
+        std::cout << "lag: " << probe.lag().count() << "ns, "
+                  << (admitted ? "admitted\n" : "shed\n");
+        std::this_thread::sleep_for(50ms);
+    }
+}
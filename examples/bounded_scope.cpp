@@ -0,0 +1,34 @@
+#include <stdexec/execution.hpp>
+#include <exec/task.hpp>
+#include <asio/steady_timer.hpp>
+
+#include "asio2exec.hpp"
+
+#include <iostream>
+
+namespace ex = stdexec;
+using namespace asio2exec;
+
+exec::task<void> session(asio_context& ctx, int id){
+    asio::steady_timer timer{ctx.context(), std::chrono::seconds(id)};
+    std::cout << "Session " << id << " started.\n";
+    co_await timer.async_wait(use_sender);
+    std::cout << "Session " << id << " finished.\n";
+}
+
+int main(){
+    asio_context ctx;
+    ctx.start();
+
+    bounded_scope scope{ctx, 3};
+
+    for(int i = 0; i < 10; ++i){
+        // 同时运行的会话达到3个时，spawn会等待空位
+        ex::sync_wait(scope.spawn(session(ctx, i)));
+        std::cout << "In flight: " << scope.in_flight() << '\n';
+    }
+
+    // 请求所有会话停止，并等待它们结束
+    scope.join();
+    std::cout << "Drained.\n";
+}
@@ -0,0 +1,46 @@
+#include <stdexec/execution.hpp>
+#include <asio/random_access_file.hpp>
+
+#include "asio2exec.hpp"
+
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace ex = stdexec;
+
+int main(int argc, char **argv) {
+#if defined(ASIO_HAS_FILE)
+    if(argc < 2){
+        std::cout << "Usage: file_read <FILE>\n";
+        return -1;
+    }
+
+    asio2exec::asio_context ctx;
+    ctx.start();
+
+    asio::random_access_file file{ctx.context(), argv[1], asio::random_access_file::read_only};
+
+    std::vector<std::array<char, 16>> records(8);
+    std::vector<asio2exec::file_range> ranges;
+    for(std::size_t i = 0; i < records.size(); ++i)
+        ranges.push_back({ .offset = i * 64, .buffer = asio::buffer(records[i]) });
+
+    auto work = ex::schedule(ctx.get_scheduler()) |
+                ex::let_value([&]{
+                    return asio2exec::read_many_at(file, ranges);
+                }) |
+                ex::then([](std::span<asio2exec::file_range> results){
+                    for(const auto& r: results){
+                        if(r.ec)
+                            std::cout << r.offset << ": " << r.ec.message() << '\n';
+                        else
+                            std::cout << r.offset << ": " << r.bytes_transferred << " bytes\n";
+                    }
+                });
+
+    stdexec::sync_wait(std::move(work));
+#else
+    std::cout << "asio file support is not available, build with io_uring (ASIO_TO_EXEC_USE_IO_URING) on Linux.\n";
+#endif
+}
@@ -0,0 +1,36 @@
+#define ASIO_TO_EXEC_ENABLE_METRICS
+
+#include <stdexec/execution.hpp>
+#include <asio/steady_timer.hpp>
+
+#include "asio2exec.hpp"
+
+#include <iostream>
+
+namespace ex = stdexec;
+
+int main() {
+    asio2exec::asio_context ctx;
+    ctx.start();
+
+    asio::steady_timer timer{ctx.context(), std::chrono::milliseconds(100)};
+
+    auto work = ex::schedule(ctx.get_scheduler()) |
+                ex::let_value([&]{
+                    return timer.async_wait(asio2exec::use_sender);
+                }) |
+                ex::then([](asio::error_code){});
+
+    for(int i = 0; i < 10; ++i)
+        ex::sync_wait(ex::schedule(ctx.get_scheduler()));
+    ex::sync_wait(std::move(work));
+
+    const asio2exec::context_metrics_snapshot m = ctx.metrics().snapshot();
+    std::cout << "posted: " << m.handlers_posted
+              << ", executed: " << m.handlers_executed
+              << ", queue depth: " << m.queue_depth << '\n'
+              << "schedule latency p50: " << m.schedule_latency.percentile(0.5).count() << "ns"
+              << ", p99: " << m.schedule_latency.percentile(0.99).count() << "ns\n"
+              << "io latency p50: " << m.io_latency.percentile(0.5).count() << "ns\n"
+              << "sbo hits: " << m.sbo_hits << ", upstream allocations: " << m.upstream_allocations << '\n';
+}
@@ -0,0 +1,75 @@
+#include <stdexec/execution.hpp>
+#include <exec/start_detached.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+
+#include "asio2exec.hpp"
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace ex = stdexec;
+using asio::ip::tcp;
+
+// 本地回显服务：原样返回每个帧(包括请求id)
+void echo_server(tcp::acceptor& acceptor){
+    tcp::socket socket = acceptor.accept();
+    std::array<char, asio2exec::multiplex_client<tcp::socket>::header_size> header;
+    std::string payload;
+    asio::error_code ec;
+    for(;;){
+        asio::read(socket, asio::buffer(header), ec);
+        if(ec)
+            return;
+        const auto* u = reinterpret_cast<const unsigned char*>(header.data());
+        payload.resize((std::size_t{u[0]} << 24) | (std::size_t{u[1]} << 16) | (std::size_t{u[2]} << 8) | u[3]);
+        asio::read(socket, asio::buffer(payload), ec);
+        if(ec)
+            return;
+        const std::array<asio::const_buffer, 2> frame{ asio::buffer(header), asio::buffer(payload) };
+        asio::write(socket, frame, ec);
+        if(ec)
+            return;
+    }
+}
+
+int main() {
+    asio2exec::asio_context ctx;
+    ctx.start();
+
+    tcp::acceptor acceptor{ ctx.context(), tcp::endpoint{asio::ip::make_address_v4("127.0.0.1"), 0} };
+    std::thread server{ [&]{ echo_server(acceptor); } };
+
+    tcp::socket socket{ ctx.context() };
+    socket.connect(acceptor.local_endpoint());
+
+    // 一个读操作为所有请求分发响应
+    asio2exec::multiplex_client<tcp::socket> client{ socket };
+    exec::start_detached(client.run() | ex::then([](asio::error_code ec){
+        std::cout << "connection closed: " << ec.message() << '\n';
+    }));
+
+    const std::string a{"ping"}, b{"hello"}, c{"multiplexed"};
+    std::array<char, 64> ra, rb, rc;
+    auto print = [](std::array<char, 64>& buf){
+        return ex::then([&buf](asio::error_code ec, std::size_t n){
+            if(ec)
+                throw asio::system_error{ec};
+            std::cout << std::string_view{buf.data(), n} << '\n';
+        });
+    };
+
+    // 三个请求同时在同一条连接上等待响应
+    ex::sync_wait(ex::when_all(
+        client.request(asio::buffer(a), asio::buffer(ra)) | print(ra),
+        client.request(asio::buffer(b), asio::buffer(rb)) | print(rb),
+        client.request(asio::buffer(c), asio::buffer(rc)) | print(rc)
+    ));
+
+    socket.shutdown(tcp::socket::shutdown_send);
+    server.join();
+    ctx.join();
+}
@@ -0,0 +1,46 @@
+#include <stdexec/execution.hpp>
+#include <exec/start_detached.hpp>
+
+#include "asio2exec.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace ex = stdexec;
+using asio2exec::priority;
+
+void busy(std::chrono::microseconds d){
+    const auto until = std::chrono::steady_clock::now() + d;
+    while(std::chrono::steady_clock::now() < until)
+        ;
+}
+
+void print(const char* name, const asio2exec::lane_stats& st){
+    std::cout << name << ": executed " << st.executed
+              << ", mean wait " << st.mean_wait().count() / 1000 << "us"
+              << ", max wait " << st.max_wait.count() / 1000 << "us"
+              << ", promoted " << st.promoted << '\n';
+}
+
+int main() {
+    asio2exec::asio_context ctx;
+    ctx.set_priority_policy({ .strict = false, .weights{8, 4, 1}, .starvation_limit = std::chrono::milliseconds(20) });
+    ctx.start();
+
+    // 大量批量导出的续体
+    for(int i = 0; i < 20000; ++i)
+        exec::start_detached(ex::schedule(ctx.get_scheduler(priority::low)) | ex::then([]{ busy(std::chrono::microseconds(10)); }));
+
+    // 同时到达的心跳
+    for(int i = 0; i < 100; ++i){
+        exec::start_detached(ex::schedule(ctx.get_scheduler(priority::high)) | ex::then([]{}));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ex::sync_wait(ex::schedule(ctx.get_scheduler(priority::low)));
+
+    print("high", ctx.priority_stats(priority::high));
+    print("normal", ctx.priority_stats(priority::normal));
+    print("low", ctx.priority_stats(priority::low));
+}
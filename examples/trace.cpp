@@ -0,0 +1,33 @@
+#define ASIO_TO_EXEC_ENABLE_TRACING
+
+#include <stdexec/execution.hpp>
+#include <asio/steady_timer.hpp>
+
+#include "asio2exec.hpp"
+
+#include <fstream>
+#include <iostream>
+
+namespace ex = stdexec;
+
+int main() {
+    asio2exec::asio_context ctx1;
+    asio2exec::asio_context ctx2;
+    ctx1.start();
+    ctx2.start();
+
+    asio::steady_timer timer{ctx1.context(), std::chrono::milliseconds(20)};
+
+    auto work = ex::schedule(ctx1.get_scheduler()) |
+                ex::let_value([&]{
+                    return timer.async_wait(asio2exec::use_sender);
+                }) |
+                ex::continues_on(ctx2.get_scheduler()) |
+                ex::then([](asio::error_code){});
+
+    ex::sync_wait(std::move(work));
+
+    std::ofstream out{"asio2exec_trace.json"};
+    asio2exec::write_chrome_trace(out);
+    std::cout << "Trace written to asio2exec_trace.json, open it in chrome://tracing or ui.perfetto.dev\n";
+}
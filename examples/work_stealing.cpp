@@ -0,0 +1,39 @@
+#include <stdexec/execution.hpp>
+#include <asio/steady_timer.hpp>
+
+#include "asio2exec.hpp"
+
+#include <iostream>
+
+namespace ex = stdexec;
+
+int main() {
+    asio2exec::work_stealing_context ctx{4};
+    ctx.start();
+
+    auto sched = ctx.get_scheduler();
+    asio::steady_timer timer{ctx.get_executor(), std::chrono::seconds(1)};
+
+    auto cpu_work = [&](int i){
+        return  ex::schedule(sched) |
+                ex::then([i]{
+                    std::uint64_t acc = 0;
+                    for(std::uint64_t n = 0; n < 10'000'000; ++n)
+                        acc += n ^ i;
+                    return acc;
+                });
+    };
+
+    auto work = ex::when_all(
+                    cpu_work(1),
+                    cpu_work(2),
+                    cpu_work(3),
+                    timer.async_wait(asio2exec::use_sender)
+                ) |
+                ex::then([](auto a, auto b, auto c, asio::error_code ec){
+                    std::cout << "CPU results: " << a << ' ' << b << ' ' << c
+                              << ", timer: " << ec.message() << '\n';
+                });
+
+    ex::sync_wait(ex::starts_on(sched, std::move(work)));
+}